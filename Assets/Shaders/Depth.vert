@@ -0,0 +1,62 @@
+#version 460 core
+#extension GL_ARB_separate_shader_objects : enable
+
+layout(location = 0) uniform mat4 projection;
+layout(location = 1) uniform mat4 view;
+layout(location = 2) uniform bool mergedInstances = false;
+
+struct MeshLODProperty {
+    uint BaseVertex;
+    uint BaseIndex;
+    uint IndexCount;
+    uint BaseMeshlet;
+    uint MeshletCount;
+    float Error;
+    uint _padding[2];
+};
+
+struct MeshProperty {
+    MeshLODProperty LODs[4];
+    vec4 BSphere;
+    vec4 PositionOffset;
+    vec4 PositionScale;
+};
+
+layout(std430, binding = 1) readonly buffer InstanceBlock {
+    mat4 modelMatrices[];
+};
+
+layout(std430, binding = 3) readonly buffer DrawablesBlock {
+    uvec4 drawables[];
+};
+
+layout(std430, binding = 6) readonly buffer MeshPropertyBlock {
+    MeshProperty meshProperties[];
+};
+
+// drawables in the order of the merged instances, see InstanceBuckets.comp
+layout(std430, binding = 12) readonly buffer InstanceRemapBlock {
+    uint instanceRemap[];
+};
+
+layout(location = 0) in vec3 in_Position;
+
+out gl_PerVertex {
+    vec4 gl_Position;
+};
+
+// must match Mesh.vert bit for bit, the shading pass tests depth for equality
+invariant gl_Position;
+
+void main() {
+    // culling writes the drawable index as the base instance, merged instances index the remap buffer from it instead
+    uint drawable = mergedInstances ? instanceRemap[gl_BaseInstance + gl_InstanceID] : uint(gl_BaseInstance);
+    mat4 model = modelMatrices[drawable];
+
+    MeshProperty mesh = meshProperties[drawables[drawable].y];
+    vec3 position = mesh.PositionOffset.xyz + in_Position * mesh.PositionScale.xyz;
+
+    vec4 worldPos = model * vec4(position, 1.0);
+
+    gl_Position = projection * view * worldPos;
+}
@@ -4,17 +4,55 @@
 
 layout(location = 0) uniform mat4 projection;
 layout(location = 1) uniform mat4 view;
+layout(location = 2) uniform bool packedVertices = false;
+layout(location = 3) uniform bool mergedInstances = false;
+
+struct MeshLODProperty {
+    uint BaseVertex;
+    uint BaseIndex;
+    uint IndexCount;
+    uint BaseMeshlet;
+    uint MeshletCount;
+    float Error;
+    uint _padding[2];
+};
+
+struct MeshProperty {
+    MeshLODProperty LODs[4];
+    vec4 BSphere;
+    vec4 PositionOffset;
+    vec4 PositionScale;
+};
+
+layout(std430, binding = 1) readonly buffer InstanceBlock {
+    mat4 modelMatrices[];
+};
+
+layout(std430, binding = 3) readonly buffer DrawablesBlock {
+    uvec4 drawables[];
+};
+
+layout(std430, binding = 6) readonly buffer MeshPropertyBlock {
+    MeshProperty meshProperties[];
+};
+
+// drawables in the order of the merged instances, see InstanceBuckets.comp
+layout(std430, binding = 12) readonly buffer InstanceRemapBlock {
+    uint instanceRemap[];
+};
 
 layout(location = 0) in vec3 in_Position;
 layout(location = 1) in vec3 in_Normal;
 layout(location = 2) in vec2 in_TexCoord;
 layout(location = 3) in vec3 in_Tangent;
-layout(location = 4) in mat4 in_model;
 
 out gl_PerVertex {
     vec4 gl_Position;
 };
 
+// must match Depth.vert bit for bit, the depth prepass output is tested for equality
+invariant gl_Position;
+
 out VS_out {
     mat3 TBN;
     vec3 FragPos;
@@ -24,12 +62,30 @@ out VS_out {
 }
 vs_out;
 
+// Packed normals and tangents are octahedral encoded into two snorm components.
+vec3 octahedralDecode(vec2 e) {
+    vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    if (v.z < 0.0) {
+        v.xy = (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return normalize(v);
+}
+
 void main() {
-    vec4 worldPos = in_model * vec4(in_Position, 1.0);
-    mat3 normalMatrix = transpose(inverse(mat3(in_model)));
+    // culling writes the drawable index as the base instance, merged instances index the remap buffer from it instead
+    uint drawable = mergedInstances ? instanceRemap[gl_BaseInstance + gl_InstanceID] : uint(gl_BaseInstance);
+    mat4 model = modelMatrices[drawable];
+
+    MeshProperty mesh = meshProperties[drawables[drawable].y];
+    vec3 position = mesh.PositionOffset.xyz + in_Position * mesh.PositionScale.xyz;
+    vec3 normal = packedVertices ? octahedralDecode(in_Normal.xy) : in_Normal;
+    vec3 tangent = packedVertices ? octahedralDecode(in_Tangent.xy) : in_Tangent;
+
+    vec4 worldPos = model * vec4(position, 1.0);
+    mat3 normalMatrix = transpose(inverse(mat3(model)));
 
-    vec3 T = normalize(normalMatrix * in_Tangent);
-    vec3 N = normalize(normalMatrix * in_Normal);
+    vec3 T = normalize(normalMatrix * tangent);
+    vec3 N = normalize(normalMatrix * normal);
     T = normalize(T - dot(T, N) * N);
     vec3 B = cross(N, T);
 
@@ -37,7 +93,8 @@ void main() {
     vs_out.FragPos = worldPos.xyz;
     // vs_out.Normal = normalMatrix * in_Normal;
     vs_out.TexCoord = in_TexCoord;
-    vs_out.drawID = gl_DrawID;
+    // one draw per meshlet or per merged LOD, so the draw ID no longer identifies the drawable
+    vs_out.drawID = drawable;
 
     gl_Position = projection * view * worldPos;
 }
\ No newline at end of file
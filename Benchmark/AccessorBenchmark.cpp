@@ -0,0 +1,175 @@
+#include "AccessorView.hpp"
+#include "Benchmark.hpp"
+#include "Graphics.hpp"
+
+#include <fmt/core.h>
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+// Converts glTF-like vertex and index buffers the way the loader did, through one temporary per attribute, and with the
+// accessor views writing straight into the vertices; float and KHR_mesh_quantization style integer attributes are covered.
+
+using Graphics::AccessorView;
+using Graphics::ComponentType;
+using Graphics::Vertex;
+
+constexpr size_t Iterations = 20;
+
+#if defined(__AVX2__)
+constexpr auto SimdName = "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64)
+constexpr auto SimdName = "SSE2";
+#else
+constexpr auto SimdName = "scalar";
+#endif
+
+// One attribute of an interleaved buffer, `offset` bytes into every element.
+struct Attribute {
+    ComponentType componentType;
+    uint32_t components;
+    bool normalized;
+    size_t offset;
+};
+
+struct VertexLayout {
+    const char* name;
+    size_t stride;
+    std::array<Attribute, 3> attributes;
+};
+
+static auto attributeView(const std::vector<uint8_t>& buffer, size_t count, size_t stride, const Attribute& attribute) -> AccessorView {
+    return { .data = std::data(buffer) + attribute.offset,
+        .count = count,
+        .stride = stride,
+        .componentType = attribute.componentType,
+        .components = attribute.components,
+        .normalized = attribute.normalized };
+}
+
+static auto createBuffer(size_t size) -> std::vector<uint8_t> {
+    std::mt19937 random { 7 };
+    std::vector<uint8_t> buffer(size);
+    for (auto& byte : buffer) {
+        byte = static_cast<uint8_t>(random() & 0x3f);
+    }
+
+    return buffer;
+}
+
+// The previous loader path, only ever handled float attributes.
+static auto convertWithTemporaries(const std::vector<uint8_t>& buffer, size_t count, size_t stride) -> std::vector<Vertex> {
+    std::vector<vec3> positions(count);
+    std::vector<vec3> normals(count);
+    std::vector<vec2> texcoords(count);
+
+    for (size_t i = 0; i < count; i++) {
+        std::memcpy(&positions[i], std::data(buffer) + i * stride, sizeof(vec3));
+    }
+    for (size_t i = 0; i < count; i++) {
+        std::memcpy(&normals[i], std::data(buffer) + i * stride + sizeof(vec3), sizeof(vec3));
+    }
+    for (size_t i = 0; i < count; i++) {
+        std::memcpy(&texcoords[i], std::data(buffer) + i * stride + 2 * sizeof(vec3), sizeof(vec2));
+    }
+
+    std::vector<Vertex> vertices(count);
+    for (size_t i = 0; i < count; i++) {
+        vertices[i].position = positions[i];
+        vertices[i].normal = normals[i];
+        vertices[i].uv = texcoords[i];
+    }
+
+    return vertices;
+}
+
+static auto convertWithViews(const std::vector<uint8_t>& buffer, size_t count, const VertexLayout& layout) -> std::vector<Vertex> {
+    std::vector<Vertex> vertices(count);
+
+    float* destinations[] = { &vertices[0].position.x, &vertices[0].normal.x, &vertices[0].uv.x };
+    for (size_t i = 0; i < std::size(layout.attributes); i++) {
+        const auto& attribute = layout.attributes[i];
+        const auto view = attributeView(buffer, count, layout.stride, attribute);
+        Graphics::gatherFloats(view, destinations[i], sizeof(Vertex), attribute.components);
+    }
+
+    return vertices;
+}
+
+int main() {
+    constexpr size_t VertexCount = 1'000'000;
+    constexpr size_t IndexCount = 3'000'000;
+
+    const std::array layouts = {
+        VertexLayout { "float", 32,
+            { Attribute { ComponentType::Float32, 3, false, 0 }, Attribute { ComponentType::Float32, 3, false, 12 },
+                Attribute { ComponentType::Float32, 2, false, 24 } } },
+        // positions padded to 4 byte alignment, as glTF requires for vertex attributes
+        VertexLayout { "quantized", 16,
+            { Attribute { ComponentType::Int16, 3, false, 0 }, Attribute { ComponentType::Int8, 3, true, 8 },
+                Attribute { ComponentType::UInt16, 2, true, 12 } } },
+        VertexLayout { "quantized unorm8 uv", 16,
+            { Attribute { ComponentType::UInt16, 3, true, 0 }, Attribute { ComponentType::Int16, 3, true, 6 },
+                Attribute { ComponentType::UInt8, 2, true, 12 } } },
+    };
+
+    fmt::println("conversion kernels: {}", SimdName);
+    fmt::println("{:>22} {:>14} {:>14} {:>10} {:>12}", "vertices", "temps ns/v", "views ns/v", "speedup", "views GB/s");
+
+    for (const auto& layout : layouts) {
+        const auto buffer = createBuffer(VertexCount * layout.stride);
+
+        const auto views = Benchmark::measure(Iterations, [&] { Benchmark::doNotOptimize(convertWithViews(buffer, VertexCount, layout)); });
+
+        const auto perVertex = [](double time) { return time / static_cast<double>(VertexCount); };
+        const auto throughput = static_cast<double>(std::size(buffer)) / views;
+
+        if (layout.attributes[0].componentType != ComponentType::Float32) {
+            fmt::println("{:>22} {:>14} {:>14.2f} {:>10} {:>12.2f}", layout.name, "-", perVertex(views), "-", throughput);
+            continue;
+        }
+
+        const auto temporaries = Benchmark::measure(
+            Iterations, [&] { Benchmark::doNotOptimize(convertWithTemporaries(buffer, VertexCount, layout.stride)); });
+
+        fmt::println("{:>22} {:>14.2f} {:>14.2f} {:>9.2f}x {:>12.2f}", layout.name, perVertex(temporaries), perVertex(views),
+            temporaries / views, throughput);
+    }
+
+    fmt::println("");
+    fmt::println("{:>22} {:>14} {:>14} {:>10} {:>12}", "indices", "scalar ns/i", "widen ns/i", "speedup", "widen GB/s");
+
+    for (const auto componentType : { ComponentType::UInt8, ComponentType::UInt16, ComponentType::UInt32 }) {
+        const auto size = Graphics::componentSize(componentType);
+        const auto buffer = createBuffer(IndexCount * size);
+        const AccessorView view {
+            .data = std::data(buffer), .count = IndexCount, .stride = size, .componentType = componentType, .components = 1
+        };
+
+        std::vector<uint32_t> indices(IndexCount);
+
+        const auto scalar = Benchmark::measure(Iterations, [&] {
+            for (size_t i = 0; i < IndexCount; i++) {
+                uint32_t index = 0;
+                std::memcpy(&index, std::data(buffer) + i * size, size);
+                indices[i] = index;
+            }
+            Benchmark::doNotOptimize(indices);
+        });
+
+        const auto widened = Benchmark::measure(Iterations, [&] {
+            Graphics::widenIndices(view, indices);
+            Benchmark::doNotOptimize(indices);
+        });
+
+        const auto perIndex = [](double time) { return time / static_cast<double>(IndexCount); };
+
+        fmt::println("{:>22} {:>14.2f} {:>14.2f} {:>9.2f}x {:>12.2f}", fmt::format("{}-bit", size * 8), perIndex(scalar), perIndex(widened),
+            scalar / widened, static_cast<double>(std::size(buffer)) / widened);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+namespace Benchmark {
+
+template <typename T> inline auto doNotOptimize(const T& value) -> void {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile const T* sink = nullptr;
+    sink = &value;
+#endif
+}
+
+// Runs `func` `iterations` times and returns the average duration of one call in nanoseconds.
+template <typename Func> inline auto measure(size_t iterations, Func&& func) -> double {
+    using clock = std::chrono::steady_clock;
+
+    const auto start = clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        func();
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+
+    return elapsed / static_cast<double>(iterations);
+}
+
+} // namespace Benchmark
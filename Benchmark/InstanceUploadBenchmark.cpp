@@ -0,0 +1,187 @@
+#include "Benchmark.hpp"
+#include "Math.hpp"
+#include "RingBuffer.hpp"
+
+#define GLAD_GL_IMPLEMENTATION
+#include <glad/gl.h>
+
+#include <GLFW/glfw3.h>
+
+#include <fmt/core.h>
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <vector>
+
+// Compares the per-frame instance upload paths: orphaning with glNamedBufferData versus writing into a persistently mapped ring.
+
+constexpr size_t FrameCount = 60;
+
+struct Drawable {
+    uint32_t materialRef { 0 };
+    uint32_t meshRef { 0 };
+};
+
+static auto fillFrame(mat4* matrices, Drawable* drawables, size_t count, size_t frame) -> void {
+    for (size_t i = 0; i < count; i++) {
+        matrices[i] = glm::translate(mat4 { 1.f }, vec3 { static_cast<float>(i), static_cast<float>(frame), 0.f });
+        drawables[i] = { static_cast<uint32_t>(i & 7), static_cast<uint32_t>(i & 15) };
+    }
+}
+
+// Reads every matrix and drawable, one invocation each, with the culling pass bindings. The sink is only written for values
+// that never occur, which keeps the reads from being optimized away.
+constexpr auto ConsumeShaderSource = R"(#version 460 core
+layout(local_size_x = 256) in;
+
+layout(std430, binding = 0) writeonly buffer SinkBlock {
+    float sink[];
+};
+
+layout(std430, binding = 1) readonly buffer InstanceBlock {
+    mat4 modelMatrices[];
+};
+
+layout(std430, binding = 3) readonly buffer DrawableBlock {
+    uvec2 drawables[];
+};
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= modelMatrices.length())
+        return;
+
+    float value = modelMatrices[index][3].x + float(drawables[index].x + drawables[index].y);
+    if (value < 0.0)
+        sink[0] = value;
+}
+)";
+
+struct Consumer {
+    uint32_t program { 0 };
+    uint32_t sink { 0 };
+};
+
+static auto createConsumer() -> Consumer {
+    Consumer consumer;
+    consumer.program = glCreateShaderProgramv(GL_COMPUTE_SHADER, 1, &ConsumeShaderSource);
+
+    glCreateBuffers(1, &consumer.sink);
+    glNamedBufferStorage(consumer.sink, sizeof(float), nullptr, 0);
+
+    return consumer;
+}
+
+static auto destroyConsumer(Consumer& consumer) -> void {
+    glDeleteProgram(consumer.program);
+    glDeleteBuffers(1, &consumer.sink);
+    consumer = {};
+}
+
+// Makes the GPU read both buffers like the culling pass does, so the ring waits for it and orphaning has storage in use.
+static auto consume(const Consumer& consumer, uint32_t instanceBuffer, size_t instanceOffset, uint32_t drawableBuffer,
+    size_t drawableOffset, size_t count) -> void {
+    glUseProgram(consumer.program);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, consumer.sink);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, instanceBuffer, instanceOffset, count * sizeof(mat4));
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 3, drawableBuffer, drawableOffset, count * sizeof(Drawable));
+    glDispatchCompute(static_cast<uint32_t>((count + 255) / 256), 1, 1);
+    glFlush();
+}
+
+static auto runOrphaning(const Consumer& consumer, size_t count) -> double {
+    std::vector<mat4> matrices(count);
+    std::vector<Drawable> drawables(count);
+
+    uint32_t buffers[2] = {};
+    glCreateBuffers(2, buffers);
+
+    glFinish();
+
+    const auto duration = Benchmark::measure(FrameCount, [&, frame = size_t { 0 }]() mutable {
+        fillFrame(std::data(matrices), std::data(drawables), count, frame++);
+
+        glNamedBufferData(buffers[0], count * sizeof(mat4), std::data(matrices), GL_DYNAMIC_DRAW);
+        glNamedBufferData(buffers[1], count * sizeof(Drawable), std::data(drawables), GL_DYNAMIC_DRAW);
+
+        consume(consumer, buffers[0], 0, buffers[1], 0, count);
+    });
+
+    glFinish();
+    glDeleteBuffers(2, buffers);
+
+    return duration;
+}
+
+static auto runRingBuffer(const Consumer& consumer, size_t count) -> double {
+    auto instances = Graphics::createRingBuffer({ .tag = 1, .frameSize = count * sizeof(mat4) });
+    auto drawables = Graphics::createRingBuffer({ .tag = 2, .frameSize = count * sizeof(Drawable) });
+
+    glFinish();
+
+    const auto duration = Benchmark::measure(FrameCount, [&, frame = size_t { 0 }]() mutable {
+        auto matrices = reinterpret_cast<mat4*>(std::data(Graphics::acquireRingBufferFrame(instances, count * sizeof(mat4))));
+        auto items = reinterpret_cast<Drawable*>(std::data(Graphics::acquireRingBufferFrame(drawables, count * sizeof(Drawable))));
+
+        fillFrame(matrices, items, count, frame++);
+
+        consume(consumer, instances.id, Graphics::ringBufferOffset(instances), drawables.id, Graphics::ringBufferOffset(drawables),
+            count);
+
+        Graphics::releaseRingBufferFrame(instances);
+        Graphics::releaseRingBufferFrame(drawables);
+    });
+
+    glFinish();
+
+    Graphics::destroyRingBuffer(instances);
+    Graphics::destroyRingBuffer(drawables);
+
+    return duration;
+}
+
+int main() {
+    if (!glfwInit()) {
+        return EXIT_FAILURE;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, true);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, false);
+
+    auto window = glfwCreateWindow(64, 64, "InstanceUploadBenchmark", nullptr, nullptr);
+    if (!window) {
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoaderLoadGL()) {
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+
+    auto consumer = createConsumer();
+
+    constexpr std::array InstanceCounts = { size_t { 10'000 }, size_t { 100'000 }, size_t { 1'000'000 } };
+
+    fmt::println("{:>10} {:>18} {:>18} {:>10}", "instances", "orphaning ms/frame", "ring ms/frame", "speedup");
+
+    for (const auto count : InstanceCounts) {
+        const auto orphaning = runOrphaning(consumer, count) * 1e-6;
+        const auto ring = runRingBuffer(consumer, count) * 1e-6;
+
+        fmt::println("{:>10} {:>18.3f} {:>18.3f} {:>9.2f}x", count, orphaning, ring, orphaning / ring);
+    }
+
+    destroyConsumer(consumer);
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include "Benchmark.hpp"
+#include "JobSystem.hpp"
+#include "MeshProcessing.hpp"
+
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_INCLUDE_JSON
+#define TINYGLTF_NO_STB_IMAGE
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+
+#include <tiny_gltf.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Measures glTF mesh processing (conversion, tangents, optimization and LOD generation) of the bundled models for growing thread counts.
+
+constexpr size_t Iterations = 3;
+
+constexpr std::array ModelPaths = {
+    RESOURCE_PATH "/Models/BoxTextured/BoxTextured.gltf",
+    RESOURCE_PATH "/Models/Duck/Duck.gltf",
+    RESOURCE_PATH "/Models/WaterBottle/WaterBottle.gltf",
+    RESOURCE_PATH "/Models/DamagedHelmet/DamagedHelmet.gltf",
+};
+
+// Images are irrelevant for mesh processing, so they are left undecoded.
+static auto skipImage(tinygltf::Image*, const int, std::string*, std::string*, int, int, const unsigned char*, int, void*) -> bool {
+    return true;
+}
+
+static auto loadModels() -> std::vector<tinygltf::Model> {
+    std::vector<tinygltf::Model> models;
+
+    tinygltf::TinyGLTF loader;
+    loader.SetImageLoader(skipImage, nullptr);
+
+    for (const auto path : ModelPaths) {
+        std::string err;
+        std::string warn;
+
+        auto& model = models.emplace_back();
+        if (!loader.LoadASCIIFromFile(&model, &err, &warn, path)) {
+            fmt::println("failed to load {}: {}", path, err);
+            models.pop_back();
+        }
+    }
+
+    return models;
+}
+
+int main() {
+    const auto models = loadModels();
+    if (models.empty()) {
+        return EXIT_FAILURE;
+    }
+
+    std::vector<size_t> threadCounts;
+    for (size_t count = 1; count < std::thread::hardware_concurrency(); count *= 2) {
+        threadCounts.push_back(count);
+    }
+    threadCounts.push_back(std::max<size_t>(std::thread::hardware_concurrency(), 1));
+
+    fmt::println("{:>8} {:>12} {:>10}", "threads", "ms/load", "speedup");
+
+    double baseline = 0.0;
+    for (const auto threadCount : threadCounts) {
+        Graphics::JobSystem jobs { threadCount };
+
+        const auto duration = Benchmark::measure(Iterations, [&] {
+            for (const auto& model : models) {
+                Benchmark::doNotOptimize(Graphics::processMeshes(jobs, model));
+            }
+        });
+
+        if (baseline == 0.0) {
+            baseline = duration;
+        }
+
+        fmt::println("{:>8} {:>12.2f} {:>9.2f}x", threadCount, duration * 1e-6, baseline / duration);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,79 @@
+#include "Benchmark.hpp"
+#include "Hash.hpp"
+#include "TagIndex.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <random>
+#include <string>
+#include <vector>
+
+struct Resource {
+    uint64_t tag { 0 };
+    uint32_t id { 0 };
+};
+
+static auto findLinear(const std::vector<Resource>& resources, uint64_t tag) -> uint32_t {
+    for (const auto& r : resources) {
+        if (r.tag == tag) {
+            return r.id;
+        }
+    }
+
+    return 0;
+}
+
+static auto findIndexed(const std::vector<Resource>& resources, const Graphics::TagIndex& index, uint64_t tag) -> uint32_t {
+    if (auto ref = index.find(tag); ref != Graphics::TagIndex::InvalidRef) {
+        return resources[ref].id;
+    }
+
+    return 0;
+}
+
+int main() {
+    constexpr size_t LookupCount = 4096;
+    constexpr std::array ResourceCounts = { 16, 64, 256, 1024, 4096, 16384, 65536 };
+
+    std::mt19937_64 rng { 42 };
+
+    fmt::println("{:>10} {:>16} {:>16} {:>10}", "resources", "linear ns/find", "indexed ns/find", "speedup");
+
+    for (const auto count : ResourceCounts) {
+        std::vector<Resource> resources;
+        Graphics::TagIndex index;
+
+        for (int i = 0; i < count; i++) {
+            const auto tag = make_hash(fmt::format("Assets/Textures/texture_{}.png", i));
+            index.insert(tag, static_cast<uint32_t>(std::size(resources)));
+            resources.push_back({ tag, static_cast<uint32_t>(i + 1) });
+        }
+
+        std::vector<uint64_t> lookups;
+        lookups.resize(LookupCount);
+        for (auto& tag : lookups) {
+            tag = resources[rng() % std::size(resources)].tag;
+        }
+
+        const size_t iterations = std::max<size_t>(1, 1 << 20 >> std::bit_width(static_cast<size_t>(count)));
+
+        const auto linear = Benchmark::measure(iterations, [&] {
+            for (const auto tag : lookups) {
+                Benchmark::doNotOptimize(findLinear(resources, tag));
+            }
+        });
+
+        const auto indexed = Benchmark::measure(iterations, [&] {
+            for (const auto tag : lookups) {
+                Benchmark::doNotOptimize(findIndexed(resources, index, tag));
+            }
+        });
+
+        fmt::println("{:>10} {:>16.2f} {:>16.2f} {:>9.1f}x", count, linear / LookupCount, indexed / LookupCount, linear / indexed);
+    }
+
+    return 0;
+}
@@ -0,0 +1,131 @@
+#include "Benchmark.hpp"
+#include "BlockCompression.hpp"
+#include "ImageDecode.hpp"
+#include "JobSystem.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <span>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Encodes the bundled glTF textures to the block format their material slot is baked to, and reports the encoding throughput
+// on one and on all threads together with the PSNR over the channels the format keeps.
+
+using Graphics::Format;
+
+constexpr size_t Iterations = 3;
+
+struct TextureCase {
+    std::string_view path;
+    Format format;
+};
+
+constexpr std::array TextureCases = {
+    TextureCase { RESOURCE_PATH "/Models/BoxTextured/CesiumLogoFlat.png", Format::BC7_UNORM },
+    TextureCase { RESOURCE_PATH "/Models/Duck/DuckCM.png", Format::BC7_UNORM },
+    TextureCase { RESOURCE_PATH "/Models/WaterBottle/WaterBottle_baseColor.png", Format::BC7_UNORM },
+    TextureCase { RESOURCE_PATH "/Models/WaterBottle/WaterBottle_normal.png", Format::BC5_UNORM },
+    TextureCase { RESOURCE_PATH "/Models/WaterBottle/WaterBottle_emissive.png", Format::BC1_RGB_UNORM },
+    TextureCase { RESOURCE_PATH "/Models/WaterBottle/WaterBottle_occlusionRoughnessMetallic.png", Format::BC7_UNORM },
+    TextureCase { RESOURCE_PATH "/Models/DamagedHelmet/Default_albedo.jpg", Format::BC7_UNORM },
+    TextureCase { RESOURCE_PATH "/Models/DamagedHelmet/Default_normal.jpg", Format::BC5_UNORM },
+    TextureCase { RESOURCE_PATH "/Models/DamagedHelmet/Default_AO.jpg", Format::BC4_UNORM },
+    TextureCase { RESOURCE_PATH "/Models/DamagedHelmet/Default_emissive.jpg", Format::BC1_RGB_UNORM },
+    TextureCase { RESOURCE_PATH "/Models/DamagedHelmet/Default_metalRoughness.jpg", Format::BC7_UNORM },
+};
+
+static auto formatName(Format format) -> std::string_view {
+    switch (format) {
+    case Format::BC1_RGB_UNORM:
+        return "BC1";
+    case Format::BC4_UNORM:
+        return "BC4";
+    case Format::BC5_UNORM:
+        return "BC5";
+    case Format::BC7_UNORM:
+        return "BC7";
+    default:
+        return "?";
+    }
+}
+
+static auto formatChannels(Format format) -> size_t {
+    switch (format) {
+    case Format::BC1_RGB_UNORM:
+        return 3;
+    case Format::BC4_UNORM:
+        return 1;
+    case Format::BC5_UNORM:
+        return 2;
+    default:
+        return 4;
+    }
+}
+
+static auto psnr(std::span<const uint8_t> original, std::span<const uint8_t> decoded, size_t channels) -> double {
+    double squaredError = 0.0;
+    const size_t pixelCount = std::size(original) / 4;
+
+    for (size_t i = 0; i < pixelCount; i++) {
+        for (size_t c = 0; c < channels; c++) {
+            const double error = static_cast<double>(original[i * 4 + c]) - static_cast<double>(decoded[i * 4 + c]);
+            squaredError += error * error;
+        }
+    }
+
+    const double mse = squaredError / static_cast<double>(pixelCount * channels);
+
+    return mse > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mse) : INFINITY;
+}
+
+int main() {
+    const size_t threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+    Graphics::JobSystem serialJobs { 1 };
+    Graphics::JobSystem parallelJobs { threadCount };
+
+    fmt::println("{:<40} {:>6} {:>11} {:>10} {:>10} {:>12} {:>8}", "texture", "format", "size", "ms 1T", "ms NT", "MPix/s NT",
+        "PSNR");
+
+    double totalSerial = 0.0;
+    double totalParallel = 0.0;
+    double totalPixels = 0.0;
+
+    for (const auto& [path, format] : TextureCases) {
+        const auto image = Graphics::decodeImageFile(path, 4);
+        if (!image) {
+            fmt::println("failed to load {}", path);
+            continue;
+        }
+
+        const auto serial = Benchmark::measure(Iterations, [&] {
+            Benchmark::doNotOptimize(Graphics::compressImage(serialJobs, format, image.data(), image.width, image.height));
+        });
+
+        std::vector<uint8_t> blocks;
+        const auto parallel = Benchmark::measure(
+            Iterations, [&] { blocks = Graphics::compressImage(parallelJobs, format, image.data(), image.width, image.height); });
+
+        const auto decoded = Graphics::decompressImage(format, blocks, image.width, image.height);
+        const double pixels = static_cast<double>(image.width) * image.height;
+
+        const auto name = path.substr(path.find_last_of('/') + 1);
+        fmt::println("{:<40} {:>6} {:>5}x{:<5} {:>10.2f} {:>10.2f} {:>12.1f} {:>8.2f}", name, formatName(format), image.width,
+            image.height, serial * 1e-6, parallel * 1e-6, pixels / (parallel * 1e-3), psnr(image.data(), decoded, formatChannels(format)));
+
+        totalSerial += serial;
+        totalParallel += parallel;
+        totalPixels += pixels;
+    }
+
+    fmt::println("total {:.2f} ms on 1 thread, {:.2f} ms on {} threads ({:.2f}x), {:.1f} MPix/s", totalSerial * 1e-6, totalParallel * 1e-6,
+        threadCount, totalSerial / totalParallel, totalPixels / (totalParallel * 1e-3));
+
+    return EXIT_SUCCESS;
+}
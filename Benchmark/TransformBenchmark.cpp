@@ -0,0 +1,113 @@
+#include "Benchmark.hpp"
+#include "TransformStore.hpp"
+
+#include <fmt/core.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// Compares composing world matrices with glm per entity, chained translate/rotate/scale as the sample used to and from a
+// quaternion, against the structure-of-arrays batch kernel.
+
+using Graphics::Transform;
+using Graphics::TransformStore;
+
+// The same transforms, as the chained glm path takes them.
+struct AxisAngleTransform {
+    vec3 position;
+    vec3 axis;
+    float angle;
+    vec3 scale;
+};
+
+constexpr size_t Iterations = 20;
+
+#if defined(__AVX2__)
+constexpr auto SimdName = "AVX2";
+#elif defined(__SSE2__) || defined(_M_X64)
+constexpr auto SimdName = "SSE2";
+#else
+constexpr auto SimdName = "scalar";
+#endif
+
+static auto createTransforms(size_t count) -> std::vector<AxisAngleTransform> {
+    std::vector<AxisAngleTransform> transforms(count);
+    for (size_t i = 0; i < count; i++) {
+        const float t = static_cast<float>(i);
+        transforms[i] = {
+            .position = { std::sin(t) * 100.f, std::cos(t * 0.5f) * 100.f, t * 0.01f },
+            .axis = glm::normalize(vec3 { std::sin(t * 0.3f), 1.f, std::cos(t * 0.7f) }),
+            .angle = t * 0.1f,
+            .scale = vec3 { 0.5f + std::fmod(t, 3.f) },
+        };
+    }
+
+    return transforms;
+}
+
+int main() {
+    constexpr std::array EntityCounts = { size_t { 10'000 }, size_t { 100'000 }, size_t { 1'000'000 } };
+
+    fmt::println("batch kernel: {}", SimdName);
+    fmt::println("{:>10} {:>14} {:>14} {:>14} {:>10} {:>12}", "entities", "chained ns/e", "quat ns/e", "SoA ns/e", "speedup", "max error");
+
+    for (const auto count : EntityCounts) {
+        const auto axisAngles = createTransforms(count);
+
+        std::vector<Transform> transforms(count);
+        TransformStore store;
+        store.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            const auto& source = axisAngles[i];
+            transforms[i] = { .position = source.position, .rotation = glm::angleAxis(source.angle, source.axis), .scale = source.scale };
+            store.set(i, transforms[i]);
+        }
+
+        std::vector<mat4> chainedMatrices(count);
+        std::vector<mat4> quatMatrices(count);
+        std::vector<mat4> batchMatrices(count);
+
+        const auto chained = Benchmark::measure(Iterations, [&] {
+            for (size_t i = 0; i < count; i++) {
+                const auto& transform = axisAngles[i];
+                auto matrix = glm::translate(mat4 { 1.f }, transform.position);
+                matrix = glm::rotate(matrix, transform.angle, transform.axis);
+                chainedMatrices[i] = glm::scale(matrix, transform.scale);
+            }
+            Benchmark::doNotOptimize(chainedMatrices);
+        });
+
+        const auto quaternion = Benchmark::measure(Iterations, [&] {
+            for (size_t i = 0; i < count; i++) {
+                const auto& transform = transforms[i];
+                quatMatrices[i] = glm::translate(mat4 { 1.f }, transform.position) * glm::mat4_cast(transform.rotation)
+                    * glm::scale(mat4 { 1.f }, transform.scale);
+            }
+            Benchmark::doNotOptimize(quatMatrices);
+        });
+
+        const auto batch = Benchmark::measure(Iterations, [&] {
+            Graphics::composeWorldMatrices(store, 0, batchMatrices);
+            Benchmark::doNotOptimize(batchMatrices);
+        });
+
+        float maxError = 0.f;
+        for (size_t i = 0; i < count; i++) {
+            for (int c = 0; c < 4; c++) {
+                for (int r = 0; r < 4; r++) {
+                    maxError = std::max(maxError, std::abs(batchMatrices[i][c][r] - chainedMatrices[i][c][r]));
+                }
+            }
+        }
+
+        const auto perEntity = [count](double time) { return time / static_cast<double>(count); };
+
+        fmt::println("{:>10} {:>14.2f} {:>14.2f} {:>14.2f} {:>9.2f}x {:>12.2e}", count, perEntity(chained), perEntity(quaternion),
+            perEntity(batch), chained / batch, maxError);
+    }
+
+    return EXIT_SUCCESS;
+}
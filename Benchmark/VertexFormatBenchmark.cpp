@@ -0,0 +1,241 @@
+#include "Benchmark.hpp"
+#include "Graphics.hpp"
+#include "VertexQuantization.hpp"
+
+#define GLAD_GL_IMPLEMENTATION
+#include <glad/gl.h>
+
+#include <GLFW/glfw3.h>
+
+#include <fmt/core.h>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <span>
+#include <vector>
+
+// Compares vertex fetch of the float and the packed vertex layouts, both with every attribute and with the position stream
+// alone as depth-only passes use it. Every vertex is pulled through a vertex shader with the rasterizer discarded, so the GPU
+// time is dominated by attribute fetch.
+
+using Graphics::PackedAttributes;
+using Graphics::PackedPosition;
+using Graphics::Vertex;
+using Graphics::VertexAttributes;
+
+// Vertex streams of one layout, as the renderer stores them.
+struct VertexStreams {
+    uint32_t positions { 0 };
+    uint32_t attributes { 0 };
+    size_t positionSize { 0 };
+    size_t attributeSize { 0 };
+};
+
+constexpr size_t DrawCount = 20;
+
+constexpr auto FetchShaderSource = R"(
+#version 460 core
+
+layout(location = 0) in vec4 in_Position;
+layout(location = 1) in vec4 in_Normal;
+layout(location = 2) in vec2 in_TexCoord;
+layout(location = 3) in vec4 in_Tangent;
+
+void main() {
+    gl_Position = in_Position + in_Normal + in_Tangent + vec4(in_TexCoord, 0.0, 0.0);
+}
+)";
+
+constexpr auto PositionShaderSource = R"(
+#version 460 core
+
+layout(location = 0) in vec4 in_Position;
+
+void main() {
+    gl_Position = in_Position;
+}
+)";
+
+// A wavy grid, so the attributes are not trivially compressible.
+static auto createVertices(size_t count) -> std::vector<Vertex> {
+    const auto side = static_cast<size_t>(std::sqrt(static_cast<double>(count)));
+
+    std::vector<Vertex> vertices(count);
+    for (size_t i = 0; i < count; i++) {
+        const float u = static_cast<float>(i % side) / static_cast<float>(side);
+        const float v = static_cast<float>(i / side) / static_cast<float>(side);
+        const float height = std::sin(u * 40.f) * std::cos(v * 40.f);
+
+        vertices[i] = {
+            .position = { u * 100.f, height, v * 100.f },
+            .normal = glm::normalize(vec3 { -std::cos(u * 40.f), 1.f, std::sin(v * 40.f) }),
+            .uv = { u * 8.f, v * 8.f },
+            .tangent = glm::normalize(vec3 { 1.f, std::cos(u * 40.f), 0.f }),
+        };
+    }
+
+    return vertices;
+}
+
+static auto createStreams(std::span<const Vertex> vertices, bool packed) -> VertexStreams {
+    const auto count = std::size(vertices);
+
+    VertexStreams streams;
+    glCreateBuffers(1, &streams.positions);
+    glCreateBuffers(1, &streams.attributes);
+
+    if (packed) {
+        std::vector<PackedPosition> positions(count);
+        std::vector<PackedAttributes> attributes(count);
+        Graphics::quantizeVertices(vertices, positions, attributes);
+
+        streams.positionSize = sizeof(PackedPosition);
+        streams.attributeSize = sizeof(PackedAttributes);
+        glNamedBufferStorage(streams.positions, count * sizeof(PackedPosition), std::data(positions), 0);
+        glNamedBufferStorage(streams.attributes, count * sizeof(PackedAttributes), std::data(attributes), 0);
+    } else {
+        std::vector<vec3> positions(count);
+        std::vector<VertexAttributes> attributes(count);
+        for (size_t i = 0; i < count; i++) {
+            positions[i] = vertices[i].position;
+            attributes[i] = { .normal = vertices[i].normal, .uv = vertices[i].uv, .tangent = vertices[i].tangent };
+        }
+
+        streams.positionSize = sizeof(vec3);
+        streams.attributeSize = sizeof(VertexAttributes);
+        glNamedBufferStorage(streams.positions, count * sizeof(vec3), std::data(positions), 0);
+        glNamedBufferStorage(streams.attributes, count * sizeof(VertexAttributes), std::data(attributes), 0);
+    }
+
+    return streams;
+}
+
+// Same attribute setup as the renderer: positions in binding 0 and, unless `positionOnly`, the rest in binding 1.
+static auto createVertexArray(const VertexStreams& streams, bool packed, bool positionOnly) -> uint32_t {
+    auto vao = 0u;
+    glCreateVertexArrays(1, &vao);
+
+    if (packed) {
+        glVertexArrayAttribFormat(vao, 0, 4, GL_UNSIGNED_SHORT, GL_TRUE, 0);
+        glVertexArrayAttribFormat(vao, 1, 2, GL_SHORT, GL_TRUE, offsetof(PackedAttributes, normal));
+        glVertexArrayAttribFormat(vao, 2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedAttributes, uv));
+        glVertexArrayAttribFormat(vao, 3, 2, GL_SHORT, GL_TRUE, offsetof(PackedAttributes, tangent));
+    } else {
+        glVertexArrayAttribFormat(vao, 0, 3, GL_FLOAT, GL_FALSE, 0);
+        glVertexArrayAttribFormat(vao, 1, 3, GL_FLOAT, GL_FALSE, offsetof(VertexAttributes, normal));
+        glVertexArrayAttribFormat(vao, 2, 2, GL_FLOAT, GL_FALSE, offsetof(VertexAttributes, uv));
+        glVertexArrayAttribFormat(vao, 3, 3, GL_FLOAT, GL_FALSE, offsetof(VertexAttributes, tangent));
+    }
+
+    glVertexArrayVertexBuffer(vao, 0, streams.positions, 0, static_cast<GLsizei>(streams.positionSize));
+    glVertexArrayAttribBinding(vao, 0, 0);
+    glEnableVertexArrayAttrib(vao, 0);
+
+    if (!positionOnly) {
+        glVertexArrayVertexBuffer(vao, 1, streams.attributes, 0, static_cast<GLsizei>(streams.attributeSize));
+        for (uint32_t attrib = 1; attrib < 4; attrib++) {
+            glVertexArrayAttribBinding(vao, attrib, 1);
+            glEnableVertexArrayAttrib(vao, attrib);
+        }
+    }
+
+    return vao;
+}
+
+// Returns the average GPU time of one draw over all vertices in nanoseconds.
+static auto measureFetch(uint32_t program, uint32_t vao, size_t vertexCount) -> double {
+    glUseProgram(program);
+    glBindVertexArray(vao);
+
+    // warm up, the first draw may include buffer residency work
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(vertexCount));
+
+    auto query = 0u;
+    glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    for (size_t i = 0; i < DrawCount; i++) {
+        glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(vertexCount));
+    }
+    glEndQuery(GL_TIME_ELAPSED);
+
+    GLuint64 elapsed = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &elapsed);
+    glDeleteQueries(1, &query);
+
+    return static_cast<double>(elapsed) / static_cast<double>(DrawCount);
+}
+
+int main() {
+    if (!glfwInit()) {
+        return EXIT_FAILURE;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 6);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, true);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, false);
+
+    auto window = glfwCreateWindow(64, 64, "VertexFormatBenchmark", nullptr, nullptr);
+    if (!window) {
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+
+    glfwMakeContextCurrent(window);
+
+    if (!gladLoaderLoadGL()) {
+        glfwTerminate();
+        return EXIT_FAILURE;
+    }
+
+    const auto fetchProgram = glCreateShaderProgramv(GL_VERTEX_SHADER, 1, &FetchShaderSource);
+    const auto positionProgram = glCreateShaderProgramv(GL_VERTEX_SHADER, 1, &PositionShaderSource);
+    glEnable(GL_RASTERIZER_DISCARD);
+
+    constexpr std::array VertexCounts = { size_t { 100'000 }, size_t { 1'000'000 }, size_t { 10'000'000 } };
+
+    fmt::println("{:>10} {:>7} {:>8} {:>7} {:>10} {:>10} {:>10} {:>12}", "vertices", "layout", "stream", "B/vert", "ms", "GB/s",
+        "Mvert/s", "quantize ms");
+
+    for (const auto count : VertexCounts) {
+        const auto vertices = createVertices(count);
+
+        std::vector<PackedPosition> positions(count);
+        std::vector<PackedAttributes> attributes(count);
+        const auto quantize = Benchmark::measure(5, [&] {
+            const auto quantization = Graphics::quantizeVertices(vertices, positions, attributes);
+            Benchmark::doNotOptimize(quantization);
+        });
+
+        for (const bool packed : { false, true }) {
+            const auto streams = createStreams(vertices, packed);
+
+            for (const bool positionOnly : { false, true }) {
+                const auto vao = createVertexArray(streams, packed, positionOnly);
+                const auto time = measureFetch(positionOnly ? positionProgram : fetchProgram, vao, count);
+                const size_t vertexSize = streams.positionSize + (positionOnly ? 0 : streams.attributeSize);
+
+                fmt::println("{:>10} {:>7} {:>8} {:>7} {:>10.3f} {:>10.1f} {:>10.1f} {:>12.3f}", count, packed ? "packed" : "float",
+                    positionOnly ? "position" : "all", vertexSize, time * 1e-6, static_cast<double>(count * vertexSize) / time,
+                    static_cast<double>(count) / time * 1e3, quantize * 1e-6);
+
+                glDeleteVertexArrays(1, &vao);
+            }
+
+            const uint32_t buffers[2] = { streams.positions, streams.attributes };
+            glDeleteBuffers(2, buffers);
+        }
+    }
+
+    glDeleteProgram(fetchProgram);
+    glDeleteProgram(positionProgram);
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+
+    return EXIT_SUCCESS;
+}
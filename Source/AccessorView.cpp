@@ -0,0 +1,368 @@
+#include "AccessorView.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define ACCESSOR_VIEW_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define ACCESSOR_VIEW_SSE2
+#endif
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+
+namespace Graphics {
+
+// Elements converted at a time, small enough for the converted floats to stay in L1.
+constexpr size_t ConversionBlockSize = 64;
+constexpr size_t MaxComponents = 16;
+
+auto componentSize(ComponentType type) -> size_t {
+    switch (type) {
+    case ComponentType::Int8:
+    case ComponentType::UInt8:
+        return 1;
+    case ComponentType::Int16:
+    case ComponentType::UInt16:
+        return 2;
+    case ComponentType::UInt32:
+    case ComponentType::Float32:
+        return 4;
+    }
+
+    return 0;
+}
+
+auto AccessorView::elementSize() const noexcept -> size_t {
+    return componentSize(componentType) * components;
+}
+
+// Normalized integers are divided by their largest value, signed ones are clamped to -1 since the smallest value is one below.
+static auto normalizationScale(ComponentType type) -> float {
+    switch (type) {
+    case ComponentType::Int8:
+        return 1.f / 127.f;
+    case ComponentType::UInt8:
+        return 1.f / 255.f;
+    case ComponentType::Int16:
+        return 1.f / 32767.f;
+    case ComponentType::UInt16:
+        return 1.f / 65535.f;
+    case ComponentType::UInt32:
+        return 1.f / 4294967295.f;
+    case ComponentType::Float32:
+        return 1.f;
+    }
+
+    return 1.f;
+}
+
+template <typename T> static auto loadValue(const uint8_t* source) -> T {
+    T value;
+    std::memcpy(&value, source, sizeof(T));
+
+    return value;
+}
+
+static auto loadComponent(ComponentType type, const uint8_t* source) -> float {
+    switch (type) {
+    case ComponentType::Int8:
+        return static_cast<float>(loadValue<int8_t>(source));
+    case ComponentType::UInt8:
+        return static_cast<float>(loadValue<uint8_t>(source));
+    case ComponentType::Int16:
+        return static_cast<float>(loadValue<int16_t>(source));
+    case ComponentType::UInt16:
+        return static_cast<float>(loadValue<uint16_t>(source));
+    case ComponentType::UInt32:
+        return static_cast<float>(loadValue<uint32_t>(source));
+    case ComponentType::Float32:
+        return loadValue<float>(source);
+    }
+
+    return 0.f;
+}
+
+#ifdef ACCESSOR_VIEW_SSE2
+struct SSE2 {
+    using Register = __m128;
+    static constexpr size_t Width = 4;
+
+    static auto loadUInt8(const uint8_t* source) -> Register {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bytes = _mm_cvtsi32_si128(loadValue<int32_t>(source));
+
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+    }
+
+    // every byte is moved to the top of its lane and shifted back down, which extends the sign
+    static auto loadInt8(const uint8_t* source) -> Register {
+        const __m128i bytes = _mm_cvtsi32_si128(loadValue<int32_t>(source));
+        const __m128i words = _mm_unpacklo_epi8(bytes, bytes);
+
+        return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(words, words), 24));
+    }
+
+    static auto loadUInt16(const uint8_t* source) -> Register {
+        const __m128i words = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source));
+
+        return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, _mm_setzero_si128()));
+    }
+
+    static auto loadInt16(const uint8_t* source) -> Register {
+        const __m128i words = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source));
+
+        return _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16));
+    }
+
+    static auto set(float value) -> Register {
+        return _mm_set1_ps(value);
+    }
+
+    static auto mul(Register a, Register b) -> Register {
+        return _mm_mul_ps(a, b);
+    }
+
+    static auto max(Register a, Register b) -> Register {
+        return _mm_max_ps(a, b);
+    }
+
+    static auto store(float* values, Register value) -> void {
+        _mm_storeu_ps(values, value);
+    }
+
+    static auto widenUInt8(const uint8_t* source, uint32_t* indices) -> void {
+        const __m128i zero = _mm_setzero_si128();
+        const __m128i bytes = _mm_cvtsi32_si128(loadValue<int32_t>(source));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), _mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+    }
+
+    static auto widenUInt16(const uint8_t* source, uint32_t* indices) -> void {
+        const __m128i words = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(source));
+
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(indices), _mm_unpacklo_epi16(words, _mm_setzero_si128()));
+    }
+};
+#endif
+
+#ifdef ACCESSOR_VIEW_AVX2
+struct AVX2 {
+    using Register = __m256;
+    static constexpr size_t Width = 8;
+
+    static auto loadUInt8(const uint8_t* source) -> Register {
+        return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source))));
+    }
+
+    static auto loadInt8(const uint8_t* source) -> Register {
+        return _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source))));
+    }
+
+    static auto loadUInt16(const uint8_t* source) -> Register {
+        return _mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source))));
+    }
+
+    static auto loadInt16(const uint8_t* source) -> Register {
+        return _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source))));
+    }
+
+    static auto set(float value) -> Register {
+        return _mm256_set1_ps(value);
+    }
+
+    static auto mul(Register a, Register b) -> Register {
+        return _mm256_mul_ps(a, b);
+    }
+
+    static auto max(Register a, Register b) -> Register {
+        return _mm256_max_ps(a, b);
+    }
+
+    static auto store(float* values, Register value) -> void {
+        _mm256_storeu_ps(values, value);
+    }
+
+    static auto widenUInt8(const uint8_t* source, uint32_t* indices) -> void {
+        const __m256i widened = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(source)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(indices), widened);
+    }
+
+    static auto widenUInt16(const uint8_t* source, uint32_t* indices) -> void {
+        const __m256i widened = _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(source)));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(indices), widened);
+    }
+};
+#endif
+
+// Converts whole registers of packed 8 and 16-bit components, returns how many were converted; 32-bit integers are left to the
+// scalar path, the signed conversion would get the large ones wrong.
+template <typename Simd>
+static auto convertComponentsBatch(ComponentType type, const uint8_t* source, size_t count, float scale, float minimum, float* values)
+    -> size_t {
+    const auto scales = Simd::set(scale);
+    const auto minimums = Simd::set(minimum);
+
+    size_t i = 0;
+    const auto convert = [&](size_t size, auto load) {
+        for (; i + Simd::Width <= count; i += Simd::Width) {
+            Simd::store(values + i, Simd::max(Simd::mul(load(source + i * size), scales), minimums));
+        }
+    };
+
+    switch (type) {
+    case ComponentType::Int8:
+        convert(1, [](const uint8_t* values) { return Simd::loadInt8(values); });
+        break;
+    case ComponentType::UInt8:
+        convert(1, [](const uint8_t* values) { return Simd::loadUInt8(values); });
+        break;
+    case ComponentType::Int16:
+        convert(2, [](const uint8_t* values) { return Simd::loadInt16(values); });
+        break;
+    case ComponentType::UInt16:
+        convert(2, [](const uint8_t* values) { return Simd::loadUInt16(values); });
+        break;
+    case ComponentType::UInt32:
+    case ComponentType::Float32:
+        break;
+    }
+
+    return i;
+}
+
+// Converts `count` packed components to floats, scaled and clamped from below.
+static auto convertComponents(ComponentType type, const uint8_t* source, size_t count, float scale, float minimum, float* values)
+    -> void {
+    const size_t size = componentSize(type);
+    size_t i = 0;
+
+#ifdef ACCESSOR_VIEW_AVX2
+    i += convertComponentsBatch<AVX2>(type, source + i * size, count - i, scale, minimum, values + i);
+#endif
+
+#ifdef ACCESSOR_VIEW_SSE2
+    i += convertComponentsBatch<SSE2>(type, source + i * size, count - i, scale, minimum, values + i);
+#endif
+
+    for (; i < count; i++) {
+        values[i] = std::max(loadComponent(type, source + i * size) * scale, minimum);
+    }
+}
+
+auto gatherFloats(const AccessorView& view, float* destination, size_t destinationStride, uint32_t destinationComponents) -> void {
+    const size_t elementSize = view.elementSize();
+    const uint32_t components = std::min(view.components, destinationComponents);
+    auto* output = reinterpret_cast<uint8_t*>(destination);
+
+    if (view.data == nullptr || components == 0) {
+        return;
+    }
+
+    assert(view.components <= MaxComponents);
+
+    // floats need no conversion and are copied element by element
+    if (view.componentType == ComponentType::Float32) {
+        for (size_t i = 0; i < view.count; i++) {
+            std::memcpy(output + i * destinationStride, view.data + i * view.stride, components * sizeof(float));
+        }
+
+        return;
+    }
+
+    const bool isSigned = view.componentType == ComponentType::Int8 || view.componentType == ComponentType::Int16;
+    const float scale = view.normalized ? normalizationScale(view.componentType) : 1.f;
+    const float minimum = view.normalized && isSigned ? -1.f : std::numeric_limits<float>::lowest();
+
+    alignas(16) uint8_t packed[ConversionBlockSize * MaxComponents * sizeof(uint32_t)];
+    alignas(16) float values[ConversionBlockSize * MaxComponents];
+
+    for (size_t first = 0; first < view.count; first += ConversionBlockSize) {
+        const size_t count = std::min(ConversionBlockSize, view.count - first);
+        const uint8_t* source = view.data + first * view.stride;
+
+        // interleaved or padded elements are packed first, tightly packed ones are converted where they are
+        if (view.stride != elementSize) {
+            for (size_t i = 0; i < count; i++) {
+                std::memcpy(packed + i * elementSize, source + i * view.stride, elementSize);
+            }
+            source = packed;
+        }
+
+        convertComponents(view.componentType, source, count * view.components, scale, minimum, values);
+
+        for (size_t i = 0; i < count; i++) {
+            std::memcpy(output + (first + i) * destinationStride, values + i * view.components, components * sizeof(float));
+        }
+    }
+}
+
+template <typename Simd> static auto widenIndicesBatch(ComponentType type, const uint8_t* source, std::span<uint32_t> indices) -> size_t {
+    const size_t count = std::size(indices);
+    const size_t size = componentSize(type);
+
+    size_t i = 0;
+    for (; i + Simd::Width <= count; i += Simd::Width) {
+        if (type == ComponentType::UInt8) {
+            Simd::widenUInt8(source + i * size, std::data(indices) + i);
+        } else {
+            Simd::widenUInt16(source + i * size, std::data(indices) + i);
+        }
+    }
+
+    return i;
+}
+
+auto widenIndices(const AccessorView& view, std::span<uint32_t> indices) -> void {
+    assert(std::size(indices) >= view.count);
+
+    const size_t size = componentSize(view.componentType);
+    const size_t count = std::min(std::size(indices), view.count);
+
+    if (view.data == nullptr || view.components != 1) {
+        return;
+    }
+
+    if (view.componentType == ComponentType::UInt32 && view.stride == size) {
+        std::memcpy(std::data(indices), view.data, count * sizeof(uint32_t));
+        return;
+    }
+
+    size_t i = 0;
+
+    // index buffer views are never strided, but nothing stops an accessor from being so
+    if (view.stride == size && (view.componentType == ComponentType::UInt8 || view.componentType == ComponentType::UInt16)) {
+#ifdef ACCESSOR_VIEW_AVX2
+        i += widenIndicesBatch<AVX2>(view.componentType, view.data + i * size, indices.subspan(i, count - i));
+#endif
+
+#ifdef ACCESSOR_VIEW_SSE2
+        i += widenIndicesBatch<SSE2>(view.componentType, view.data + i * size, indices.subspan(i, count - i));
+#endif
+    }
+
+    for (; i < count; i++) {
+        const auto* source = view.data + i * view.stride;
+
+        switch (view.componentType) {
+        case ComponentType::UInt8:
+            indices[i] = loadValue<uint8_t>(source);
+            break;
+        case ComponentType::UInt16:
+            indices[i] = loadValue<uint16_t>(source);
+            break;
+        case ComponentType::UInt32:
+            indices[i] = loadValue<uint32_t>(source);
+            break;
+        default:
+            indices[i] = 0;
+            break;
+        }
+    }
+}
+
+} // namespace Graphics
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace Graphics {
+
+// Component types of glTF accessors, valued as their componentType.
+enum class ComponentType : uint32_t {
+    Int8 = 5120,
+    UInt8 = 5121,
+    Int16 = 5122,
+    UInt16 = 5123,
+    UInt32 = 5125,
+    Float32 = 5126,
+};
+
+// Elements of an accessor where they lie in the buffer: `count` elements of `components` values each, `stride` bytes apart.
+struct AccessorView {
+    auto elementSize() const noexcept -> size_t;
+
+    const uint8_t* data { nullptr };
+    size_t count { 0 };
+    size_t stride { 0 };
+    ComponentType componentType { ComponentType::Float32 };
+    uint32_t components { 0 };
+    // integer components map to [0, 1], or [-1, 1] when signed, instead of converting to their value
+    bool normalized { false };
+};
+
+auto componentSize(ComponentType type) -> size_t;
+
+// Converts every element to floats and writes it `destinationStride` bytes after the previous one, e.g. into one attribute of
+// an array of vertices. Up to `destinationComponents` components are written, the others are left alone.
+auto gatherFloats(const AccessorView& view, float* destination, size_t destinationStride, uint32_t destinationComponents) -> void;
+
+// Widens unsigned 8, 16 or 32-bit indices, `indices` holds view.count values.
+auto widenIndices(const AccessorView& view, std::span<uint32_t> indices) -> void;
+
+} // namespace Graphics
@@ -0,0 +1,670 @@
+#include "BlockCompression.hpp"
+#include "JobSystem.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define BLOCK_COMPRESSION_SSE2
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+namespace Graphics {
+
+constexpr size_t BlockPixels = BlockDimension * BlockDimension;
+
+constexpr std::array<uint32_t, 16> BC7Weights = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+// Pixels of one block, channel by channel so four pixels fit one SIMD register.
+struct Block {
+    alignas(16) float channels[4][BlockPixels];
+};
+
+struct Palette {
+    alignas(16) float entries[16][4];
+    uint32_t size { 0 };
+};
+
+struct Endpoints {
+    float start[4] {};
+    float end[4] {};
+};
+
+auto isBlockCompressed(Format format) -> bool {
+    return format >= Format::BC1_RGB_UNORM && format <= Format::BC7_UNORM;
+}
+
+auto blockSize(Format format) -> size_t {
+    switch (format) {
+    case Format::BC1_RGB_UNORM:
+    case Format::BC4_UNORM:
+        return 8;
+    case Format::BC5_UNORM:
+    case Format::BC7_UNORM:
+        return 16;
+    default:
+        return 0;
+    }
+}
+
+auto compressedSize(Format format, uint32_t width, uint32_t height) -> size_t {
+    const size_t blocksX = (width + BlockDimension - 1) / BlockDimension;
+    const size_t blocksY = (height + BlockDimension - 1) / BlockDimension;
+
+    return blocksX * blocksY * blockSize(format);
+}
+
+// Channels past `channelCount` stay zero, so they never contribute to the error.
+static auto loadBlock(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY, size_t channelCount)
+    -> Block {
+    Block block {};
+
+    for (uint32_t y = 0; y < BlockDimension; y++) {
+        // partial blocks at the right and bottom edge repeat the last pixel
+        const uint32_t py = std::min(blockY * BlockDimension + y, height - 1);
+
+        for (uint32_t x = 0; x < BlockDimension; x++) {
+            const uint32_t px = std::min(blockX * BlockDimension + x, width - 1);
+            const uint8_t* pixel = pixels + (size_t { py } * width + px) * 4;
+
+            for (size_t c = 0; c < channelCount; c++) {
+                block.channels[c][y * BlockDimension + x] = pixel[c];
+            }
+        }
+    }
+
+    return block;
+}
+
+// Picks the closest palette entry for every pixel and returns the summed squared error.
+static auto selectIndices(const Block& block, const Palette& palette, uint8_t indices[BlockPixels]) -> float {
+#ifdef BLOCK_COMPRESSION_SSE2
+    float error = 0.f;
+
+    for (size_t i = 0; i < BlockPixels; i += 4) {
+        const __m128 r = _mm_load_ps(&block.channels[0][i]);
+        const __m128 g = _mm_load_ps(&block.channels[1][i]);
+        const __m128 b = _mm_load_ps(&block.channels[2][i]);
+        const __m128 a = _mm_load_ps(&block.channels[3][i]);
+
+        __m128 best = _mm_set1_ps(FLT_MAX);
+        __m128i bestIndex = _mm_setzero_si128();
+
+        for (uint32_t j = 0; j < palette.size; j++) {
+            const __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette.entries[j][0]));
+            const __m128 dg = _mm_sub_ps(g, _mm_set1_ps(palette.entries[j][1]));
+            const __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette.entries[j][2]));
+            const __m128 da = _mm_sub_ps(a, _mm_set1_ps(palette.entries[j][3]));
+
+            const __m128 distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dr, dr), _mm_mul_ps(dg, dg)),
+                _mm_add_ps(_mm_mul_ps(db, db), _mm_mul_ps(da, da)));
+
+            const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, best));
+            best = _mm_min_ps(distance, best);
+            bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int>(j))), _mm_andnot_si128(closer, bestIndex));
+        }
+
+        alignas(16) int32_t lanes[4];
+        alignas(16) float errors[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), bestIndex);
+        _mm_store_ps(errors, best);
+
+        for (size_t lane = 0; lane < 4; lane++) {
+            indices[i + lane] = static_cast<uint8_t>(lanes[lane]);
+            error += errors[lane];
+        }
+    }
+
+    return error;
+#else
+    float error = 0.f;
+
+    for (size_t i = 0; i < BlockPixels; i++) {
+        float best = FLT_MAX;
+
+        for (uint32_t j = 0; j < palette.size; j++) {
+            float distance = 0.f;
+            for (size_t c = 0; c < 4; c++) {
+                const float d = block.channels[c][i] - palette.entries[j][c];
+                distance += d * d;
+            }
+
+            if (distance < best) {
+                best = distance;
+                indices[i] = static_cast<uint8_t>(j);
+            }
+        }
+
+        error += best;
+    }
+
+    return error;
+#endif
+}
+
+// Endpoints at the extremes of the block projected on its principal axis.
+static auto fitEndpoints(const Block& block, size_t channelCount) -> Endpoints {
+    float mean[4] {};
+    for (size_t c = 0; c < channelCount; c++) {
+        for (size_t i = 0; i < BlockPixels; i++) {
+            mean[c] += block.channels[c][i];
+        }
+        mean[c] /= BlockPixels;
+    }
+
+    float covariance[4][4] {};
+    for (size_t i = 0; i < BlockPixels; i++) {
+        for (size_t c0 = 0; c0 < channelCount; c0++) {
+            for (size_t c1 = 0; c1 < channelCount; c1++) {
+                covariance[c0][c1] += (block.channels[c0][i] - mean[c0]) * (block.channels[c1][i] - mean[c1]);
+            }
+        }
+    }
+
+    // power iteration from the covariance row of the widest channel, converges quickly enough for 4x4 blocks
+    size_t widest = 0;
+    for (size_t c = 1; c < channelCount; c++) {
+        widest = covariance[c][c] > covariance[widest][widest] ? c : widest;
+    }
+
+    float axis[4] {};
+    std::copy_n(covariance[widest], channelCount, axis);
+
+    for (size_t iteration = 0; iteration < 8; iteration++) {
+        float next[4] {};
+        float length = 0.f;
+
+        for (size_t c0 = 0; c0 < channelCount; c0++) {
+            for (size_t c1 = 0; c1 < channelCount; c1++) {
+                next[c0] += covariance[c0][c1] * axis[c1];
+            }
+            length = std::max(length, std::abs(next[c0]));
+        }
+
+        if (length < FLT_EPSILON) {
+            break;
+        }
+
+        for (size_t c = 0; c < channelCount; c++) {
+            axis[c] = next[c] / length;
+        }
+    }
+
+    float minProjection = FLT_MAX;
+    float maxProjection = -FLT_MAX;
+    float axisLength = 0.f;
+
+    for (size_t c = 0; c < channelCount; c++) {
+        axisLength += axis[c] * axis[c];
+    }
+
+    for (size_t i = 0; i < BlockPixels; i++) {
+        float projection = 0.f;
+        for (size_t c = 0; c < channelCount; c++) {
+            projection += (block.channels[c][i] - mean[c]) * axis[c];
+        }
+
+        minProjection = std::min(minProjection, projection);
+        maxProjection = std::max(maxProjection, projection);
+    }
+
+    Endpoints endpoints;
+    for (size_t c = 0; c < channelCount; c++) {
+        const float scale = axisLength > FLT_EPSILON ? axis[c] / axisLength : 0.f;
+        endpoints.start[c] = std::clamp(mean[c] + minProjection * scale, 0.f, 255.f);
+        endpoints.end[c] = std::clamp(mean[c] + maxProjection * scale, 0.f, 255.f);
+    }
+
+    return endpoints;
+}
+
+// Least squares endpoints for the chosen indices, `weights` being the position of each palette entry between start and end.
+static auto refineEndpoints(const Block& block, size_t channelCount, const uint8_t indices[BlockPixels], const float* weights,
+    Endpoints endpoints) -> Endpoints {
+    float aa = 0.f;
+    float ab = 0.f;
+    float bb = 0.f;
+    float ax[4] {};
+    float bx[4] {};
+
+    for (size_t i = 0; i < BlockPixels; i++) {
+        const float b = weights[indices[i]];
+        const float a = 1.f - b;
+
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+
+        for (size_t c = 0; c < channelCount; c++) {
+            ax[c] += a * block.channels[c][i];
+            bx[c] += b * block.channels[c][i];
+        }
+    }
+
+    const float determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < FLT_EPSILON) {
+        return endpoints;
+    }
+
+    for (size_t c = 0; c < channelCount; c++) {
+        endpoints.start[c] = std::clamp((bb * ax[c] - ab * bx[c]) / determinant, 0.f, 255.f);
+        endpoints.end[c] = std::clamp((aa * bx[c] - ab * ax[c]) / determinant, 0.f, 255.f);
+    }
+
+    return endpoints;
+}
+
+static auto packRGB565(const float color[4]) -> uint16_t {
+    const auto r = static_cast<uint32_t>(std::lround(color[0] * 31.f / 255.f));
+    const auto g = static_cast<uint32_t>(std::lround(color[1] * 63.f / 255.f));
+    const auto b = static_cast<uint32_t>(std::lround(color[2] * 31.f / 255.f));
+
+    return static_cast<uint16_t>(r << 11 | g << 5 | b);
+}
+
+static auto unpackRGB565(uint16_t color, float rgb[4]) -> void {
+    const uint32_t r = color >> 11 & 31;
+    const uint32_t g = color >> 5 & 63;
+    const uint32_t b = color & 31;
+
+    rgb[0] = static_cast<float>(r << 3 | r >> 2);
+    rgb[1] = static_cast<float>(g << 2 | g >> 4);
+    rgb[2] = static_cast<float>(b << 3 | b >> 2);
+    rgb[3] = 0.f;
+}
+
+// Four color mode palette, which needs the first endpoint to be the larger one.
+static auto makeBC1Palette(uint16_t color0, uint16_t color1) -> Palette {
+    Palette palette;
+    palette.size = color0 > color1 ? 4 : 1;
+
+    unpackRGB565(color0, palette.entries[0]);
+    unpackRGB565(color1, palette.entries[1]);
+
+    for (size_t c = 0; c < 4; c++) {
+        palette.entries[2][c] = std::floor((2.f * palette.entries[0][c] + palette.entries[1][c]) / 3.f);
+        palette.entries[3][c] = std::floor((palette.entries[0][c] + 2.f * palette.entries[1][c]) / 3.f);
+    }
+
+    return palette;
+}
+
+static auto encodeBC1Endpoints(const Block& block, const Endpoints& endpoints, uint16_t& color0, uint16_t& color1,
+    uint8_t indices[BlockPixels]) -> float {
+    color0 = packRGB565(endpoints.start);
+    color1 = packRGB565(endpoints.end);
+
+    if (color0 < color1) {
+        std::swap(color0, color1);
+    }
+
+    const auto palette = makeBC1Palette(color0, color1);
+    return selectIndices(block, palette, indices);
+}
+
+static auto encodeBC1(const Block& block, uint8_t* output) -> void {
+    constexpr float Weights[4] = { 0.f, 1.f, 1.f / 3.f, 2.f / 3.f };
+
+    uint16_t color0 = 0;
+    uint16_t color1 = 0;
+    uint8_t indices[BlockPixels] {};
+
+    const auto fitted = fitEndpoints(block, 3);
+    float error = encodeBC1Endpoints(block, fitted, color0, color1, indices);
+
+    if (color0 != color1) {
+        Endpoints ordered;
+        unpackRGB565(color0, ordered.start);
+        unpackRGB565(color1, ordered.end);
+
+        uint16_t refined0 = 0;
+        uint16_t refined1 = 0;
+        uint8_t refinedIndices[BlockPixels] {};
+
+        const auto refined = refineEndpoints(block, 3, indices, Weights, ordered);
+        if (const float refinedError = encodeBC1Endpoints(block, refined, refined0, refined1, refinedIndices); refinedError < error) {
+            error = refinedError;
+            color0 = refined0;
+            color1 = refined1;
+            std::memcpy(indices, refinedIndices, BlockPixels);
+        }
+    }
+
+    uint32_t bits = 0;
+    for (size_t i = 0; i < BlockPixels; i++) {
+        bits |= uint32_t { indices[i] } << (i * 2);
+    }
+
+    std::memcpy(output, &color0, 2);
+    std::memcpy(output + 2, &color1, 2);
+    std::memcpy(output + 4, &bits, 4);
+}
+
+// Eight value mode: index 0 and 1 are the endpoints, 2..7 interpolate from the first towards the second.
+static auto encodeBC4(const Block& block, size_t channel, uint8_t* output) -> void {
+    float minValue = 255.f;
+    float maxValue = 0.f;
+
+    for (size_t i = 0; i < BlockPixels; i++) {
+        minValue = std::min(minValue, block.channels[channel][i]);
+        maxValue = std::max(maxValue, block.channels[channel][i]);
+    }
+
+    const auto value0 = static_cast<uint8_t>(maxValue);
+    const auto value1 = static_cast<uint8_t>(minValue);
+
+    uint64_t bits = 0;
+    if (value0 != value1) {
+        const float scale = 7.f / (value0 - value1);
+
+        for (size_t i = 0; i < BlockPixels; i++) {
+            const auto step = static_cast<uint32_t>(std::lround((value0 - block.channels[channel][i]) * scale));
+            const uint64_t index = step == 0 ? 0 : step == 7 ? 1 : step + 1;
+            bits |= index << (i * 3);
+        }
+    }
+
+    output[0] = value0;
+    output[1] = value1;
+    for (size_t i = 0; i < 6; i++) {
+        output[2 + i] = static_cast<uint8_t>(bits >> (i * 8));
+    }
+}
+
+// Endpoint of BC7 mode 6 quantized to seven bits plus a shared lowest bit.
+struct BC7Endpoint {
+    uint32_t values[4] {};
+    uint32_t pbit { 0 };
+};
+
+static auto quantizeBC7Endpoint(const float color[4]) -> BC7Endpoint {
+    BC7Endpoint best;
+    float bestError = FLT_MAX;
+
+    for (uint32_t pbit = 0; pbit < 2; pbit++) {
+        BC7Endpoint endpoint { .pbit = pbit };
+        float error = 0.f;
+
+        for (size_t c = 0; c < 4; c++) {
+            endpoint.values[c] = static_cast<uint32_t>(std::clamp(std::lround((color[c] - pbit) * 0.5f), 0l, 127l));
+            const float d = static_cast<float>(endpoint.values[c] << 1 | pbit) - color[c];
+            error += d * d;
+        }
+
+        if (error < bestError) {
+            bestError = error;
+            best = endpoint;
+        }
+    }
+
+    return best;
+}
+
+static auto makeBC7Palette(const BC7Endpoint& start, const BC7Endpoint& end) -> Palette {
+    Palette palette;
+    palette.size = 16;
+
+    for (size_t i = 0; i < 16; i++) {
+        for (size_t c = 0; c < 4; c++) {
+            const uint32_t e0 = start.values[c] << 1 | start.pbit;
+            const uint32_t e1 = end.values[c] << 1 | end.pbit;
+            palette.entries[i][c] = static_cast<float>(((64 - BC7Weights[i]) * e0 + BC7Weights[i] * e1 + 32) >> 6);
+        }
+    }
+
+    return palette;
+}
+
+// 128 bit block written from the least significant bit up.
+struct BitWriter {
+    auto write(uint64_t value, uint32_t bits) -> void {
+        for (uint32_t i = 0; i < bits; i++, position++) {
+            const uint64_t bit = value >> i & 1;
+            words[position / 64] |= bit << (position % 64);
+        }
+    }
+
+    uint64_t words[2] {};
+    uint32_t position { 0 };
+};
+
+static auto encodeBC7(const Block& block, uint8_t* output) -> void {
+    float weights[16];
+    for (size_t i = 0; i < 16; i++) {
+        weights[i] = static_cast<float>(BC7Weights[i]) / 64.f;
+    }
+
+    const auto endpoints = fitEndpoints(block, 4);
+    auto start = quantizeBC7Endpoint(endpoints.start);
+    auto end = quantizeBC7Endpoint(endpoints.end);
+
+    uint8_t indices[BlockPixels] {};
+    const float error = selectIndices(block, makeBC7Palette(start, end), indices);
+
+    Endpoints fitted;
+    for (size_t c = 0; c < 4; c++) {
+        fitted.start[c] = static_cast<float>(start.values[c] << 1 | start.pbit);
+        fitted.end[c] = static_cast<float>(end.values[c] << 1 | end.pbit);
+    }
+
+    const auto refined = refineEndpoints(block, 4, indices, weights, fitted);
+    const auto refinedStart = quantizeBC7Endpoint(refined.start);
+    const auto refinedEnd = quantizeBC7Endpoint(refined.end);
+
+    uint8_t refinedIndices[BlockPixels] {};
+    if (selectIndices(block, makeBC7Palette(refinedStart, refinedEnd), refinedIndices) < error) {
+        start = refinedStart;
+        end = refinedEnd;
+        std::memcpy(indices, refinedIndices, BlockPixels);
+    }
+
+    // the anchor index is stored without its top bit, so it has to be below 8
+    if (indices[0] >= 8) {
+        std::swap(start, end);
+        for (auto& index : indices) {
+            index = static_cast<uint8_t>(15 - index);
+        }
+    }
+
+    BitWriter writer;
+    writer.write(1 << 6, 7);
+
+    for (size_t c = 0; c < 4; c++) {
+        writer.write(start.values[c], 7);
+        writer.write(end.values[c], 7);
+    }
+
+    writer.write(start.pbit, 1);
+    writer.write(end.pbit, 1);
+
+    writer.write(indices[0], 3);
+    for (size_t i = 1; i < BlockPixels; i++) {
+        writer.write(indices[i], 4);
+    }
+
+    std::memcpy(output, writer.words, 16);
+}
+
+static auto encodeBlock(Format format, const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t blockX, uint32_t blockY,
+    uint8_t* output) -> void {
+    switch (format) {
+    case Format::BC1_RGB_UNORM:
+        encodeBC1(loadBlock(pixels, width, height, blockX, blockY, 3), output);
+        break;
+    case Format::BC4_UNORM:
+        encodeBC4(loadBlock(pixels, width, height, blockX, blockY, 1), 0, output);
+        break;
+    case Format::BC5_UNORM: {
+        const auto block = loadBlock(pixels, width, height, blockX, blockY, 2);
+        encodeBC4(block, 0, output);
+        encodeBC4(block, 1, output + 8);
+        break;
+    }
+    case Format::BC7_UNORM:
+        encodeBC7(loadBlock(pixels, width, height, blockX, blockY, 4), output);
+        break;
+    default:
+        break;
+    }
+}
+
+auto compressImage(JobSystem& jobs, Format format, std::span<const uint8_t> pixels, uint32_t width, uint32_t height)
+    -> std::vector<uint8_t> {
+    const uint32_t blocksX = (width + BlockDimension - 1) / BlockDimension;
+    const uint32_t blocksY = (height + BlockDimension - 1) / BlockDimension;
+    const size_t bytes = blockSize(format);
+
+    std::vector<uint8_t> blocks(compressedSize(format, width, height));
+    if (std::empty(blocks) || std::size(pixels) < size_t { width } * height * 4) {
+        return {};
+    }
+
+    jobs.parallelFor(blocksY, [&](size_t blockY) {
+        for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+            const auto output = std::data(blocks) + (blockY * blocksX + blockX) * bytes;
+            encodeBlock(format, std::data(pixels), width, height, blockX, static_cast<uint32_t>(blockY), output);
+        }
+    });
+
+    return blocks;
+}
+
+static auto decodeBC1(const uint8_t* input, uint8_t decoded[BlockPixels][4]) -> void {
+    uint16_t color0 = 0;
+    uint16_t color1 = 0;
+    uint32_t bits = 0;
+    std::memcpy(&color0, input, 2);
+    std::memcpy(&color1, input + 2, 2);
+    std::memcpy(&bits, input + 4, 4);
+
+    auto palette = makeBC1Palette(color0, color1);
+    if (color0 <= color1) {
+        // three color mode, which the encoder never emits
+        for (size_t c = 0; c < 3; c++) {
+            palette.entries[2][c] = std::floor((palette.entries[0][c] + palette.entries[1][c]) / 2.f);
+            palette.entries[3][c] = 0.f;
+        }
+    }
+
+    for (size_t i = 0; i < BlockPixels; i++) {
+        const auto& entry = palette.entries[bits >> (i * 2) & 3];
+        decoded[i][0] = static_cast<uint8_t>(entry[0]);
+        decoded[i][1] = static_cast<uint8_t>(entry[1]);
+        decoded[i][2] = static_cast<uint8_t>(entry[2]);
+        decoded[i][3] = 255;
+    }
+}
+
+static auto decodeBC4(const uint8_t* input, uint8_t decoded[BlockPixels][4], size_t channel) -> void {
+    const uint32_t value0 = input[0];
+    const uint32_t value1 = input[1];
+
+    uint64_t bits = 0;
+    for (size_t i = 0; i < 6; i++) {
+        bits |= uint64_t { input[2 + i] } << (i * 8);
+    }
+
+    uint32_t values[8] = { value0, value1 };
+    if (value0 > value1) {
+        for (uint32_t i = 2; i < 8; i++) {
+            values[i] = ((8 - i) * value0 + (i - 1) * value1) / 7;
+        }
+    } else {
+        for (uint32_t i = 2; i < 6; i++) {
+            values[i] = ((6 - i) * value0 + (i - 1) * value1) / 5;
+        }
+        values[6] = 0;
+        values[7] = 255;
+    }
+
+    for (size_t i = 0; i < BlockPixels; i++) {
+        decoded[i][channel] = static_cast<uint8_t>(values[bits >> (i * 3) & 7]);
+    }
+}
+
+static auto decodeBC7(const uint8_t* input, uint8_t decoded[BlockPixels][4]) -> void {
+    uint64_t words[2];
+    std::memcpy(words, input, 16);
+
+    uint32_t position = 0;
+    const auto read = [&](uint32_t bits) {
+        uint32_t value = 0;
+        for (uint32_t i = 0; i < bits; i++, position++) {
+            value |= static_cast<uint32_t>(words[position / 64] >> (position % 64) & 1) << i;
+        }
+        return value;
+    };
+
+    if (read(7) != 1 << 6) {
+        std::memset(decoded, 0, BlockPixels * 4);
+        return;
+    }
+
+    BC7Endpoint start;
+    BC7Endpoint end;
+    for (size_t c = 0; c < 4; c++) {
+        start.values[c] = read(7);
+        end.values[c] = read(7);
+    }
+
+    start.pbit = read(1);
+    end.pbit = read(1);
+
+    const auto palette = makeBC7Palette(start, end);
+    for (size_t i = 0; i < BlockPixels; i++) {
+        const auto& entry = palette.entries[read(i == 0 ? 3 : 4)];
+        for (size_t c = 0; c < 4; c++) {
+            decoded[i][c] = static_cast<uint8_t>(entry[c]);
+        }
+    }
+}
+
+auto decompressImage(Format format, std::span<const uint8_t> blocks, uint32_t width, uint32_t height) -> std::vector<uint8_t> {
+    const uint32_t blocksX = (width + BlockDimension - 1) / BlockDimension;
+    const uint32_t blocksY = (height + BlockDimension - 1) / BlockDimension;
+    const size_t bytes = blockSize(format);
+
+    std::vector<uint8_t> pixels(size_t { width } * height * 4);
+    if (std::size(blocks) < compressedSize(format, width, height)) {
+        return pixels;
+    }
+
+    for (uint32_t blockY = 0; blockY < blocksY; blockY++) {
+        for (uint32_t blockX = 0; blockX < blocksX; blockX++) {
+            const auto input = std::data(blocks) + (size_t { blockY } * blocksX + blockX) * bytes;
+
+            uint8_t decoded[BlockPixels][4] {};
+            switch (format) {
+            case Format::BC1_RGB_UNORM:
+                decodeBC1(input, decoded);
+                break;
+            case Format::BC4_UNORM:
+                decodeBC4(input, decoded, 0);
+                break;
+            case Format::BC5_UNORM:
+                decodeBC4(input, decoded, 0);
+                decodeBC4(input + 8, decoded, 1);
+                break;
+            case Format::BC7_UNORM:
+                decodeBC7(input, decoded);
+                break;
+            default:
+                break;
+            }
+
+            for (uint32_t y = 0; y < BlockDimension && blockY * BlockDimension + y < height; y++) {
+                for (uint32_t x = 0; x < BlockDimension && blockX * BlockDimension + x < width; x++) {
+                    const size_t pixel = size_t { blockY * BlockDimension + y } * width + blockX * BlockDimension + x;
+                    std::memcpy(std::data(pixels) + pixel * 4, decoded[y * BlockDimension + x], 4);
+                }
+            }
+        }
+    }
+
+    return pixels;
+}
+
+} // namespace Graphics
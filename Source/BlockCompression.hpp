@@ -0,0 +1,28 @@
+#pragma once
+
+#include "Graphics.hpp"
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace Graphics {
+
+struct JobSystem;
+
+constexpr uint32_t BlockDimension = 4;
+
+auto isBlockCompressed(Format format) -> bool;
+// Bytes per 4x4 block.
+auto blockSize(Format format) -> size_t;
+auto compressedSize(Format format, uint32_t width, uint32_t height) -> size_t;
+
+// Encodes RGBA8 pixels into a BCn `format`, one job per row of blocks. BC1 ignores alpha, BC4 keeps red and BC5 red and green.
+// BC7 blocks are always written in mode 6, a single subset with 7777.1 endpoints and 4 bit indices.
+auto compressImage(JobSystem& jobs, Format format, std::span<const uint8_t> pixels, uint32_t width, uint32_t height)
+    -> std::vector<uint8_t>;
+
+// Decodes back to RGBA8 to measure the encoding error. Only BC7 mode 6 is supported, the other modes decode to zero.
+auto decompressImage(Format format, std::span<const uint8_t> blocks, uint32_t width, uint32_t height) -> std::vector<uint8_t>;
+
+} // namespace Graphics
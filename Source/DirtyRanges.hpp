@@ -0,0 +1,68 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace Graphics {
+
+// Element ranges of a CPU-side array that changed since the last upload to its GPU buffer.
+struct DirtyRanges {
+    struct Range {
+        size_t begin { 0 };
+        size_t end { 0 };
+    };
+
+    auto add(size_t first, size_t count = 1) -> void {
+        if (count == 0) {
+            return;
+        }
+
+        const size_t end = first + count;
+
+        // appends and repeated edits of the last element are by far the most common case
+        if (!ranges_.empty() && first <= ranges_.back().end && end >= ranges_.back().begin) {
+            ranges_.back().begin = std::min(ranges_.back().begin, first);
+            ranges_.back().end = std::max(ranges_.back().end, end);
+            return;
+        }
+
+        ranges_.push_back({ first, end });
+    }
+
+    // Sorts the ranges and merges the overlapping or adjacent ones.
+    auto coalesce() -> std::span<const Range> {
+        if (std::size(ranges_) < 2) {
+            return ranges_;
+        }
+
+        std::sort(std::begin(ranges_), std::end(ranges_), [](const Range& a, const Range& b) { return a.begin < b.begin; });
+
+        size_t last = 0;
+        for (size_t i = 1; i < std::size(ranges_); i++) {
+            if (ranges_[i].begin <= ranges_[last].end) {
+                ranges_[last].end = std::max(ranges_[last].end, ranges_[i].end);
+            } else {
+                ranges_[++last] = ranges_[i];
+            }
+        }
+
+        ranges_.resize(last + 1);
+
+        return ranges_;
+    }
+
+    auto empty() const noexcept -> bool {
+        return ranges_.empty();
+    }
+
+    auto clear() -> void {
+        ranges_.clear();
+    }
+
+private:
+    std::vector<Range> ranges_;
+};
+
+} // namespace Graphics
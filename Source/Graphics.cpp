@@ -1,45 +1,29 @@
 #include "Graphics.hpp"
+#include "BlockCompression.hpp"
 #include "Common.hpp"
 #include "Hash.hpp"
+#include "ImageDecode.hpp"
 #include "Log.hpp"
+#include "MeshProcessing.hpp"
 #include "Renderer.hpp"
+#include "TextureBake.hpp"
+#include "TextureStreamer.hpp"
+#include "VertexQuantization.hpp"
 
 #define GLAD_GL_IMPLEMENTATION
 #include <glad/gl.h>
 
+// the loader is generated without EXT_texture_compression_s3tc
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+
+#include <algorithm>
 #include <cassert>
 #include <fstream>
 
 namespace Graphics {
 
-inline auto getBoundingSphere(const MeshLOD& mesh) -> BoundingSphere {
-    if (mesh.vertices.empty()) {
-        return {};
-    }
-
-    vec3 minimum = mesh.vertices[0].position;
-    vec3 maximum = mesh.vertices[0].position;
-
-    for (const auto& vertex : mesh.vertices) {
-        minimum.x = std::min(minimum.x, vertex.position.x);
-        minimum.y = std::min(minimum.y, vertex.position.y);
-        minimum.z = std::min(minimum.z, vertex.position.z);
-
-        maximum.x = std::max(maximum.x, vertex.position.x);
-        maximum.y = std::max(maximum.y, vertex.position.y);
-        maximum.z = std::max(maximum.z, vertex.position.z);
-    }
-
-    vec3 center = (minimum + maximum) * 0.5f;
-
-    float radius = 0.0f;
-    for (const auto& vertex : mesh.vertices) {
-        radius = std::max(radius, length(vertex.position - center));
-    }
-
-    return { center, radius };
-}
-
 inline auto internalFormat(Format format) -> GLint {
     switch (format) {
     case Format::Undefined:
@@ -79,6 +63,15 @@ inline auto internalFormat(Format format) -> GLint {
         return GL_DEPTH_COMPONENT24;
     case Format::D16_UNORM:
         return GL_DEPTH_COMPONENT16;
+
+    case Format::BC1_RGB_UNORM:
+        return GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+    case Format::BC4_UNORM:
+        return GL_COMPRESSED_RED_RGTC1;
+    case Format::BC5_UNORM:
+        return GL_COMPRESSED_RG_RGTC2;
+    case Format::BC7_UNORM:
+        return GL_COMPRESSED_RGBA_BPTC_UNORM;
     }
 
     return 0;
@@ -123,6 +116,13 @@ inline auto imageFormat(Format format) -> std::tuple<uint32_t, uint32_t> {
         return { GL_DEPTH_COMPONENT, GL_FLOAT };
     case Format::D16_UNORM:
         return { GL_DEPTH_COMPONENT, GL_FLOAT };
+
+    // compressed images are uploaded as blocks
+    case Format::BC1_RGB_UNORM:
+    case Format::BC4_UNORM:
+    case Format::BC5_UNORM:
+    case Format::BC7_UNORM:
+        return { 0, 0 };
     }
 
     return {};
@@ -230,68 +230,51 @@ inline auto applyTextureWrap(uint32_t id, TextureWrap wrapping, bool wrapR = fal
 }
 
 auto findShader(Device& device, uint64_t tag) -> Shader {
-    for (const auto& s : device.shaders_) {
-        if (s.tag == tag) {
-            return s;
-        }
+    if (auto ref = device.shaderIndex_.find(tag); ref != TagIndex::InvalidRef) {
+        return device.shaders_[ref];
     }
 
     return {};
 }
 
 auto findPipeline(Device& device, uint64_t tag) -> Pipeline {
-    for (const auto& p : device.pipelines_) {
-        if (p.tag == tag) {
-            return p;
-        }
+    if (auto ref = device.pipelineIndex_.find(tag); ref != TagIndex::InvalidRef) {
+        return device.pipelines_[ref];
     }
 
     return {};
 }
 
 auto findTexture(Device& device, uint64_t tag) -> Texture {
-    for (const auto& t : device.textures_) {
-        if (t.tag == tag) {
-            return t;
-        }
+    if (auto ref = device.textureIndex_.find(tag); ref != TagIndex::InvalidRef) {
+        return device.textures_[ref];
     }
 
     return {};
 }
 
 auto findBuffer(Device& device, uint64_t tag) -> Buffer {
-    for (const auto& b : device.buffers_) {
-        if (b.tag == tag) {
-            return b;
-        }
+    if (auto ref = device.bufferIndex_.find(tag); ref != TagIndex::InvalidRef) {
+        return device.buffers_[ref];
     }
 
     return {};
 }
 
 auto findTextureHandleRef(Device& device, uint64_t handle) -> uint32_t {
-    uint32_t idx = 0;
-    for (const auto& h : device.textureHandles_) {
-        if (handle == h) {
-            return idx;
-        }
-
-        idx++;
+    if (auto ref = device.textureHandleIndex_.find(handle); ref != TagIndex::InvalidRef) {
+        return ref;
     }
 
-    return idx;
+    return std::size(device.textureHandles_);
 }
 
-auto findModelRef(Device& device, uint64_t tag) -> uint32_t {
-    uint32_t idx = 0;
-    for (const auto& m : device.models_) {
-        if (m.tag == tag) {
-            return idx;
-        }
-        idx++;
+auto findModelRef(Device& device, uint64_t tag) -> ModelRef {
+    if (auto ref = device.modelIndex_.find(tag); ref != TagIndex::InvalidRef) {
+        return device.models_[ref].ref;
     }
 
-    return idx;
+    return {};
 }
 
 auto loadPipeline(Device& device, uint64_t tag, std::span<const std::string_view> shaderNames) -> void {
@@ -318,6 +301,30 @@ auto Framebuffer::is_complete() const noexcept -> bool {
     return status == GL_FRAMEBUFFER_COMPLETE;
 }
 
+// Video memory of `layers` mip chains.
+static auto textureStorageSize(Format format, uint32_t width, uint32_t height, uint32_t mipLevels, uint32_t layers) -> size_t {
+    size_t size = 0;
+    for (uint32_t level = 0; level < mipLevels; level++) {
+        size += levelSize(format, std::max(width >> level, 1u), std::max(height >> level, 1u));
+    }
+
+    return size * layers;
+}
+
+// Every texture starts out with the reference of its creator.
+static auto registerTexture(Device& device, const Texture& texture, uint64_t contentKey) -> const Texture& {
+    assignSlot(device.textureRefCounts_, texture.ref.index, 1u);
+    assignSlot(device.textureContentKeys_, texture.ref.index, contentKey);
+    if (contentKey != 0) {
+        device.textureContentIndex_.insert(contentKey, texture.ref.index);
+    }
+
+    device.residentTextures++;
+    device.residentTextureBytes += texture.size;
+
+    return assignSlot(device.textures_, texture.ref.index, texture);
+}
+
 auto createTexture2D(Device& device, const TextureConfiguration& conf) -> Texture {
     uint32_t id = 0u;
     glCreateTextures(GL_TEXTURE_2D, 1, &id);
@@ -347,10 +354,142 @@ auto createTexture2D(Device& device, const TextureConfiguration& conf) -> Textur
         handle = glGetTextureHandleARB(id);
         glMakeTextureHandleResidentARB(handle);
 
-        device.textureHandles_.push_back(handle);
+        const auto handleRef = device.textureHandleSlots_.allocate();
+        device.textureHandleIndex_.insert(handle, handleRef.index);
+        assignSlot(device.textureHandles_, handleRef.index, handle);
+        device.dirtyTextureHandles_.add(handleRef.index);
     }
 
-    return device.textures_.emplace_back(conf.tag, id, GL_TEXTURE_2D, conf.width, conf.height, 0, mipLevels, handle);
+    const auto ref = device.textureSlots_.allocate();
+    device.textureIndex_.insert(conf.tag, ref.index);
+
+    const auto size = conf.samples > 1 ? levelSize(conf.format, conf.width, conf.height) * conf.samples
+                                       : textureStorageSize(conf.format, conf.width, conf.height, mipLevels, 1);
+
+    return registerTexture(
+        device, { conf.tag, id, GL_TEXTURE_2D, conf.width, conf.height, 0, mipLevels, handle, ref, size }, conf.contentKey);
+}
+
+auto acquireTexture(Device& device, uint64_t contentKey) -> Texture {
+    if (auto ref = device.textureContentIndex_.find(contentKey); ref != TagIndex::InvalidRef) {
+        device.textureRefCounts_[ref]++;
+
+        const auto& texture = device.textures_[ref];
+        device.sharedTextures++;
+        device.sharedTextureBytes += texture.size;
+
+        return texture;
+    }
+
+    return {};
+}
+
+auto streamTexture2D(Device& device, std::shared_ptr<const DecodedImage> image, TextureConfiguration conf) -> Texture {
+    // a failed decode has no size to allocate storage for
+    if (!image || !*image || image->width == 0 || image->height == 0) {
+        return {};
+    }
+
+    const size_t rowSize = image->size / image->height;
+
+    // rows that don't fit the staging ring are uploaded directly
+    if (rowSize > device.textureStreamer_.capacity) {
+        return createTexture2D(device, *image, conf);
+    }
+
+    const bool generateMipMaps = conf.generateMipMaps;
+
+    conf.width = image->width;
+    conf.height = image->height;
+    conf.format = image->format;
+    conf.generateMipMaps = false;
+    conf.pixels = {};
+
+    const auto texture = createTexture2D(device, conf);
+
+    // the texture is sampled before its pixels arrive, so it starts out cleared
+    const auto [format, type] = imageFormat(conf.format);
+    for (uint32_t level = 0; level < texture.mipLevels; level++) {
+        glClearTexImage(texture.id, level, format, type, nullptr);
+    }
+
+    const auto pixels = image->data();
+
+    queueTextureUpload(device.textureStreamer_,
+        { .texture = texture.id,
+            .width = texture.width,
+            .height = texture.height,
+            .pixelFormat = format,
+            .pixelType = type,
+            .generateMipMaps = generateMipMaps,
+            .source = std::move(image),
+            .pixels = pixels });
+
+    return texture;
+}
+
+auto streamTexture2D(Device& device, std::shared_ptr<const BakedTexture> baked, TextureConfiguration conf) -> Texture {
+    const auto& header = *baked->header;
+    const auto levels = bakedTextureLevels(*baked);
+
+    conf.width = header.width;
+    conf.height = header.height;
+    conf.format = header.format;
+    conf.mipLevels = header.levelCount;
+    conf.generateMipMaps = false;
+    conf.pixels = {};
+
+    const auto texture = createTexture2D(device, conf);
+    const auto [format, type] = imageFormat(conf.format);
+
+    const bool compressed = isBlockCompressed(conf.format);
+    const auto compressedFormat = compressed ? static_cast<uint32_t>(internalFormat(conf.format)) : 0u;
+
+    // compressed textures can't be cleared, they start out zeroed instead, which decodes to black
+    std::vector<uint8_t> zeroes;
+    if (compressed) {
+        zeroes.resize(levels[0].size);
+    }
+
+    // small levels go first, so a coarse version shows up after a frame or two
+    for (size_t i = std::size(levels); i-- > 0;) {
+        const auto pixels = bakedTextureLevelData(*baked, levels[i]);
+        const auto level = static_cast<uint32_t>(i);
+        const uint32_t width = levels[i].width;
+        const uint32_t height = levels[i].height;
+        const auto size = static_cast<GLsizei>(std::size(pixels));
+
+        const uint32_t rowHeight = compressed ? BlockDimension : 1;
+        const size_t rowSize = levelSize(conf.format, width, std::min(height, rowHeight));
+
+        if (rowSize > device.textureStreamer_.capacity) {
+            if (compressed) {
+                glCompressedTextureSubImage2D(texture.id, level, 0, 0, width, height, compressedFormat, size, std::data(pixels));
+            } else {
+                glTextureSubImage2D(texture.id, level, 0, 0, width, height, format, type, std::data(pixels));
+            }
+            continue;
+        }
+
+        if (compressed) {
+            glCompressedTextureSubImage2D(texture.id, level, 0, 0, width, height, compressedFormat, size, std::data(zeroes));
+        } else {
+            glClearTexImage(texture.id, level, format, type, nullptr);
+        }
+
+        queueTextureUpload(device.textureStreamer_,
+            { .texture = texture.id,
+                .level = level,
+                .width = width,
+                .height = height,
+                .pixelFormat = format,
+                .pixelType = type,
+                .compressedFormat = compressedFormat,
+                .source = baked,
+                .pixels = pixels });
+    }
+
+    return texture;
 }
 
 auto createTextureCube(Device& device, const TextureCubeConfiguration& conf) -> Texture {
@@ -374,7 +513,12 @@ auto createTextureCube(Device& device, const TextureCubeConfiguration& conf) ->
         glGenerateTextureMipmap(id);
     }
 
-    return device.textures_.emplace_back(conf.tag, id, GL_TEXTURE_2D, conf.width, conf.height, 0, mipLevels, 0);
+    const auto ref = device.textureSlots_.allocate();
+    device.textureIndex_.insert(conf.tag, ref.index);
+
+    const auto size = textureStorageSize(conf.format, conf.width, conf.height, mipLevels, 6);
+
+    return registerTexture(device, { conf.tag, id, GL_TEXTURE_2D, conf.width, conf.height, 0, mipLevels, 0, ref, size }, 0);
 }
 
 auto createShader(Device& device, const ShaderConfiguration& conf) -> Shader {
@@ -395,6 +539,8 @@ auto createShader(Device& device, const ShaderConfiguration& conf) -> Shader {
         exit(EXIT_FAILURE);
     }
 
+    device.shaderIndex_.insert(conf.tag, std::size(device.shaders_));
+
     return device.shaders_.emplace_back(conf.tag, id, conf.stage);
 }
 
@@ -427,6 +573,8 @@ auto createGraphicsPipeline(Device& device, const PipelineConfiguration& conf) -
         }
     }
 
+    device.pipelineIndex_.insert(conf.tag, std::size(device.pipelines_));
+
     return device.pipelines_.emplace_back(conf.tag, pipelineID);
 }
 
@@ -444,6 +592,8 @@ auto createBuffer(Device& device, const BufferConfiguration& conf) -> Buffer {
         glNamedBufferData(id, conf.emptySize, nullptr, GL_DYNAMIC_DRAW);
     }
 
+    device.bufferIndex_.insert(conf.tag, std::size(device.buffers_));
+
     return device.buffers_.emplace_back(conf.tag, id, conf.data.empty() ? conf.emptySize : std::size(conf.data));
 }
 
@@ -585,61 +735,260 @@ auto loadShader(Device& device, std::string_view filepath) -> void {
         device, { .tag = make_hash(filepath), .stage = getShaderStage(filepath), .filename = std::string { filepath }, .source = buf });
 }
 
-auto addMesh(Device& device, const Mesh& mesh) -> uint32_t {
+auto addMesh(Device& device, const Mesh& mesh) -> MeshRef {
+    const auto packed = packMesh(mesh);
+
+    return addMesh(device, packed.property, packed.vertices, packed.indices, packed.meshlets);
+}
+
+// Identifies a mesh by everything addMesh stores for it, so equal geometry loaded from different primitives or models matches.
+static auto meshContentHash(const MeshProperty& property, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+    std::span<const Meshlet> meshlets) -> uint64_t {
+    uint64_t hash = XXH64(&property, sizeof(property), 0);
+    hash = XXH64(std::data(vertices), std::size(vertices) * sizeof(Vertex), hash);
+    hash = XXH64(std::data(indices), std::size(indices) * sizeof(uint32_t), hash);
 
-    device.reloadMeshBuffers_ = true;
+    return XXH64(std::data(meshlets), std::size(meshlets) * sizeof(Meshlet), hash);
+}
 
-    MeshProperty meshProperty;
+// Geometry bytes a mesh occupies in the mega-buffers.
+static auto meshStorageSize(const Device& device, const MeshAllocation& allocation) -> size_t {
+    const size_t vertexSize = device.quantizeVertices ? sizeof(PackedPosition) + sizeof(PackedAttributes)
+                                                      : sizeof(vec3) + sizeof(VertexAttributes);
 
-    size_t idx = 0;
-    for (const auto& lod : mesh.LODs) {
-        uint32_t elementCount = std::size(lod.faces) * 3;
+    return allocation.vertices.size * vertexSize + allocation.indices.size * sizeof(uint32_t) + allocation.meshlets.size * sizeof(Meshlet);
+}
 
-        meshProperty.LODs[idx].baseVertex = std::size(device.vertices_);
-        meshProperty.LODs[idx].baseIndex = std::size(device.indices_);
-        meshProperty.LODs[idx].indexCount = elementCount;
+auto addMesh(Device& device, const MeshProperty& property, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+    std::span<const Meshlet> meshlets) -> MeshRef {
+    const auto contentHash = meshContentHash(property, vertices, indices, meshlets);
 
-        if (elementCount == 0) {
-            continue;
+    // identical geometry shares the existing mesh, every add takes a reference destroyMesh gives back
+    if (const auto index = device.meshIndex_.find(contentHash); index != TagIndex::InvalidRef) {
+        device.meshRefCounts_[index]++;
+        device.sharedMeshes++;
+        device.sharedMeshBytes += meshStorageSize(device, device.meshAllocations_[index]);
+
+        return { index, device.meshSlots_.generation(index) };
+    }
+
+    const auto vertexCount = static_cast<uint32_t>(std::size(vertices));
+
+    MeshAllocation allocation;
+    allocation.vertices = device.quantizeVertices
+        ? allocateRange(device.vertexAllocator_, vertexCount, device.packedPositions_, device.packedAttributes_)
+        : allocateRange(device.vertexAllocator_, vertexCount, device.positions_, device.vertexAttributes_);
+    allocation.indices = allocateRange(device.indexAllocator_, static_cast<uint32_t>(std::size(indices)), device.indices_);
+    allocation.meshlets = allocateRange(device.meshletAllocator_, static_cast<uint32_t>(std::size(meshlets)), device.meshlets_);
+
+    // empty meshes get no ranges and keep zero base offsets
+    const uint32_t baseVertex = allocation.vertices ? allocation.vertices.offset : 0;
+    const uint32_t baseIndex = allocation.indices ? allocation.indices.offset : 0;
+    const uint32_t baseMeshlet = allocation.meshlets ? allocation.meshlets.offset : 0;
+
+    MeshProperty meshProperty = property;
+
+    if (device.quantizeVertices) {
+        const auto quantization = quantizeVertices(vertices, std::span { device.packedPositions_ }.subspan(baseVertex, vertexCount),
+            std::span { device.packedAttributes_ }.subspan(baseVertex, vertexCount));
+        meshProperty.positionOffset = vec4 { quantization.offset, 0.f };
+        meshProperty.positionScale = vec4 { quantization.scale, 0.f };
+    } else {
+        for (uint32_t i = 0; i < vertexCount; i++) {
+            const auto& vertex = vertices[i];
+            device.positions_[baseVertex + i] = vertex.position;
+            device.vertexAttributes_[baseVertex + i] = { .normal = vertex.normal, .uv = vertex.uv, .tangent = vertex.tangent };
         }
+    }
+
+    std::copy(std::begin(indices), std::end(indices), std::begin(device.indices_) + baseIndex);
+
+    for (size_t i = 0; i < std::size(meshlets); i++) {
+        device.meshlets_[baseMeshlet + i] = meshlets[i];
+        device.meshlets_[baseMeshlet + i].firstIndex += baseIndex;
+    }
+
+    for (auto& lod : meshProperty.LODs) {
+        lod.baseVertex += baseVertex;
+        lod.baseIndex += baseIndex;
+        lod.baseMeshlet += baseMeshlet;
+    }
+
+    const auto ref = device.meshSlots_.allocate();
+    assignSlot(device.meshProperties_, ref.index, meshProperty);
+    assignSlot(device.meshAllocations_, ref.index, allocation);
+    assignSlot(device.meshHashes_, ref.index, contentHash);
+    assignSlot(device.meshRefCounts_, ref.index, 1u);
+    device.meshIndex_.insert(contentHash, ref.index);
 
-        device.vertices_.insert(std::end(device.vertices_), std::begin(lod.vertices), std::end(lod.vertices));
+    if (allocation.vertices) {
+        device.dirtyVertices_.add(allocation.vertices.offset, allocation.vertices.size);
+    }
+    if (allocation.indices) {
+        device.dirtyIndices_.add(allocation.indices.offset, allocation.indices.size);
+    }
+    if (allocation.meshlets) {
+        device.dirtyMeshlets_.add(allocation.meshlets.offset, allocation.meshlets.size);
+    }
+    device.dirtyMeshProperties_.add(ref.index);
+
+    return ref;
+}
+
+auto addMaterial(Device& device, const Material& material) -> MaterialRef {
+    const auto ref = device.materialSlots_.allocate();
+    assignSlot(device.materials_, ref.index, material);
+    device.dirtyMaterials_.add(ref.index);
+
+    return ref;
+}
+
+// TagIndex keeps the first resource created under a tag, later ones with the same tag are not indexed. When the indexed one is
+// destroyed, the next live resource with the tag takes its place, so finding by tag keeps working while any of them is alive.
+template <typename Resource> static auto eraseTag(TagIndex& index, std::span<const Resource> resources, uint32_t removed) -> void {
+    const auto tag = resources[removed].tag;
+    if (index.find(tag) != removed) {
+        return;
+    }
+
+    index.erase(tag);
 
-        for (const auto& face : lod.faces) {
-            device.indices_.push_back(face.x);
-            device.indices_.push_back(face.y);
-            device.indices_.push_back(face.z);
+    for (uint32_t i = 0; i < std::size(resources); i++) {
+        if (i != removed && resources[i].ref && resources[i].tag == tag) {
+            index.insert(tag, i);
+            return;
         }
+    }
+}
 
-        idx++;
+auto destroyTexture(Device& device, TextureRef ref) -> bool {
+    if (!device.textureSlots_.contains(ref)) {
+        return false;
     }
 
-    meshProperty.bSphere = getBoundingSphere(mesh.LODs[0]);
+    // still used by another model or material slot
+    if (--device.textureRefCounts_[ref.index] != 0) {
+        return true;
+    }
+
+    device.textureSlots_.release(ref);
+
+    auto& texture = device.textures_[ref.index];
+
+    if (const auto contentKey = device.textureContentKeys_[ref.index]; contentKey != 0) {
+        device.textureContentIndex_.erase(contentKey);
+    }
 
-    device.meshProperties_.push_back(meshProperty);
+    device.residentTextures--;
+    device.residentTextureBytes -= texture.size;
 
-    return std::size(device.meshProperties_) - 1;
+    if (texture.handle != 0) {
+        if (auto handleRef = device.textureHandleIndex_.find(texture.handle); handleRef != TagIndex::InvalidRef) {
+            glMakeTextureHandleNonResidentARB(texture.handle);
+
+            device.textureHandleIndex_.erase(texture.handle);
+            device.textureHandleSlots_.release({ handleRef, device.textureHandleSlots_.generation(handleRef) });
+            device.textureHandles_[handleRef] = 0;
+            device.dirtyTextureHandles_.add(handleRef);
+        }
+    }
+
+    eraseTag(device.textureIndex_, std::span<const Texture> { device.textures_ }, ref.index);
+
+    cancelTextureUpload(device.textureStreamer_, texture.id);
+
+    glDeleteTextures(1, &texture.id);
+    texture = {};
+
+    return true;
+}
+
+auto destroyMesh(Device& device, MeshRef ref) -> bool {
+    if (!device.meshSlots_.contains(ref)) {
+        return false;
+    }
+
+    // still used by another model or primitive
+    if (--device.meshRefCounts_[ref.index] != 0) {
+        return true;
+    }
+
+    device.meshSlots_.release(ref);
+    device.meshIndex_.erase(device.meshHashes_[ref.index]);
+
+    // the freed ranges are reused by later meshes, nothing is repacked
+    auto& allocation = device.meshAllocations_[ref.index];
+    device.vertexAllocator_.free(allocation.vertices);
+    device.indexAllocator_.free(allocation.indices);
+    device.meshletAllocator_.free(allocation.meshlets);
+    allocation = {};
+
+    device.meshProperties_[ref.index] = {};
+    device.dirtyMeshProperties_.add(ref.index);
+
+    return true;
 }
 
-auto addMaterial(Device& device, const Material& material) -> uint32_t {
-    device.reloadMaterialBuffers_ = true;
+auto destroyMaterial(Device& device, MaterialRef ref) -> bool {
+    if (!device.materialSlots_.release(ref)) {
+        return false;
+    }
 
-    device.materials_.push_back(material);
+    device.materials_[ref.index] = {};
+    device.dirtyMaterials_.add(ref.index);
 
-    return std::size(device.materials_) - 1;
+    return true;
 }
 
-auto addLight(Device& device, const Light& light) -> uint32_t {
-    device.reloadLightBuffers_ = true;
+auto destroyModel(Device& device, ModelRef ref) -> bool {
+    if (!device.modelSlots_.release(ref)) {
+        return false;
+    }
+
+    auto& model = device.models_[ref.index];
 
+    for (const auto meshRef : model.meshRefs) {
+        destroyMesh(device, meshRef);
+    }
+
+    for (const auto materialRef : model.materials) {
+        destroyMaterial(device, materialRef);
+    }
+
+    for (const auto textureRef : model.textures) {
+        destroyTexture(device, textureRef);
+    }
+
+    eraseTag(device.modelIndex_, std::span<const Model> { device.models_ }, ref.index);
+
+    model = {};
+
+    return true;
+}
+
+auto setNodeTransform(Device& device, ModelRef ref, uint32_t node, const mat4& local) -> bool {
+    if (!device.modelSlots_.contains(ref)) {
+        return false;
+    }
+
+    auto& nodes = device.models_[ref.index].nodes;
+    if (node >= nodes.size()) {
+        return false;
+    }
+
+    setLocalTransform(nodes, node, local);
+
+    return true;
+}
+
+auto addLight(Device& device, const Light& light) -> uint32_t {
     device.lights_.push_back(light);
+    device.dirtyLights_.add(std::size(device.lights_) - 1);
 
     return std::size(device.lights_) - 1;
 }
 
 auto addDirectionalLight(Device& device, const DirectionalLightConfiguration& conf) -> uint32_t {
-    device.reloadLightBuffers_ = true;
-
     Light light;
     light.position = conf.direction;
     light.color = conf.color;
@@ -647,6 +996,7 @@ auto addDirectionalLight(Device& device, const DirectionalLightConfiguration& co
     light.intensity = conf.intensity;
 
     device.lights_.push_back(light);
+    device.dirtyLights_.add(std::size(device.lights_) - 1);
 
     return std::size(device.lights_) - 1;
 }
@@ -856,7 +1206,7 @@ auto drawCube([[maybe_unused]] Device& device) -> void {
 //     return {};
 // }
 
-// auto createMesh(Device& device, const CreateMeshConfiguration& conf) -> uint32_t {
+// auto createMesh(Device& device, const CreateMeshConfiguration& conf) -> MeshRef {
 //     auto mesh = createMesh(conf);
 //     return addMesh(device, mesh);
 // }
@@ -871,7 +1221,7 @@ auto drawCube([[maybe_unused]] Device& device) -> void {
 //     return material;
 // }
 
-// auto createMaterial(Device& device, const CreateMaterialConfiguration& conf) -> uint32_t {
+// auto createMaterial(Device& device, const CreateMaterialConfiguration& conf) -> MaterialRef {
 //     auto material = createMaterial(conf);
 
 //     if (!conf.KdMapName.empty()) {
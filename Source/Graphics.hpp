@@ -1,6 +1,8 @@
 #pragma once
 
 #include "Math.hpp"
+#include "NodeHierarchy.hpp"
+#include "SlotAllocator.hpp"
 
 #include <optional>
 #include <span>
@@ -31,6 +33,11 @@ enum class Format {
     D32_UNORM,
     D24_UNORM,
     D16_UNORM,
+
+    BC1_RGB_UNORM,
+    BC4_UNORM,
+    BC5_UNORM,
+    BC7_UNORM,
 };
 
 enum class ShaderStage : uint32_t {
@@ -67,6 +74,25 @@ struct Vertex {
     vec3 tangent { 0.f };
 };
 
+// On the GPU vertices are split into a position stream and an attribute stream, so depth-only passes fetch positions alone.
+struct VertexAttributes {
+    vec3 normal { 0.f };
+    vec2 uv { 0.f };
+    vec3 tangent { 0.f };
+};
+
+// Quantized position: 16-bit unorm inside the mesh bounds, decoded with the per-mesh offset and scale of MeshProperty.
+struct PackedPosition {
+    uint16_t position[4] { 0, 0, 0, 0 };
+};
+
+// Quantized attributes: octahedral normal and tangent as 16-bit snorm pairs, half-float uv.
+struct PackedAttributes {
+    uint32_t normal { 0 };
+    uint32_t tangent { 0 };
+    uint32_t uv { 0 };
+};
+
 struct BoundingSphere {
     vec3 position { 0.f };
     float radius { 0.f };
@@ -74,40 +100,87 @@ struct BoundingSphere {
 
 constexpr size_t MaxMeshLODs = 4;
 
+constexpr size_t MaxMeshletVertices = 64;
+constexpr size_t MaxMeshletTriangles = 124;
+
 struct MeshLOD {
     std::vector<Vertex> vertices;
     std::vector<uvec3> faces;
+    // object space deviation from the full mesh introduced by simplification
+    float error { 0.f };
 };
 
 struct Mesh {
     mat4 local { 1.f };
-    uint32_t materialRef { 0xffffffff };
+    MaterialRef materialRef {};
     std::array<MeshLOD, MaxMeshLODs> LODs;
 };
 
 struct Model {
     uint64_t tag { 0 };
+    ModelRef ref {};
 
     struct SubMesh {
+        // node the submesh is attached to, and its transform relative to that node
         uint32_t parent { 0 };
         mat4 local { 1.f };
-        uint32_t materialRef { 0xffffffff };
-        uint32_t meshRef { 0xffffffff };
+        MaterialRef materialRef {};
+        MeshRef meshRef {};
     };
 
     std::vector<SubMesh> meshes;
+    // node tree of the glTF scene, with at least one root every submesh can be attached to
+    NodeHierarchy nodes;
+
+    // resources created while loading the model, released together with it; meshes hold one reference per addMesh, submeshes
+    // of nodes sharing a mesh use it without one
+    std::vector<TextureRef> textures;
+    std::vector<MaterialRef> materials;
+    std::vector<MeshRef> meshRefs;
+
+    // video memory of the textures the model references, shared ones count in every model using them
+    size_t textureBytes { 0 };
+    size_t sharedTextureBytes { 0 };
 };
 
 struct MeshLODProperty {
     uint32_t baseVertex { 0 };
     uint32_t baseIndex { 0 };
     uint32_t indexCount { 0 };
-    uint32_t padding { 0 };
+    uint32_t baseMeshlet { 0 };
+    uint32_t meshletCount { 0 };
+    // object space simplification error, projected to pixels to select the LOD
+    float error { 0.f };
+    uint32_t padding[2] { 0, 0 };
+};
+
+// Contiguous index range of one LOD with at most MaxMeshletVertices vertices and MaxMeshletTriangles triangles,
+// frustum and backface culled on its own by the culling pass.
+struct Meshlet {
+    BoundingSphere bounds;
+    vec4 coneApex { 0.f };
+    // xyz is the cone axis, w the cutoff; the meshlet is backfacing when dot(normalize(apex - eye), axis) >= cutoff
+    vec4 cone { 0.f, 0.f, 0.f, 1.f };
+    uint32_t firstIndex { 0 };
+    uint32_t indexCount { 0 };
+    uint32_t padding[2] { 0, 0 };
 };
 
 struct MeshProperty {
     std::array<MeshLODProperty, MaxMeshLODs> LODs;
     BoundingSphere bSphere;
+    // vertex positions are offset + position * scale, the identity for unpacked vertices
+    vec4 positionOffset { 0.f };
+    vec4 positionScale { 1.f };
+};
+
+// Mesh with all LODs packed back to back into one vertex, one index and one meshlet stream.
+// LOD base offsets in `property` and meshlet first indices are relative to the start of the streams.
+struct PackedMesh {
+    MeshProperty property;
+    std::vector<Vertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Meshlet> meshlets;
 };
 
 struct PBRMetallicRoughnessMaterial {
@@ -179,6 +252,9 @@ struct Texture {
     uint32_t depth = 0;
     uint32_t mipLevels = 0;
     uint64_t handle = 0;
+    TextureRef ref {};
+    // bytes of the whole mip chain in video memory
+    size_t size = 0;
 };
 
 struct Buffer {
@@ -236,6 +312,8 @@ struct TextureConfiguration {
     TextureFiltering filter = TextureFiltering::Nearest;
     TextureWrap wrap = TextureWrap::None;
     std::span<const uint8_t> pixels {};
+    // image content and sampler state; textures created with the same non-zero key are shared through acquireTexture
+    uint64_t contentKey { 0 };
 };
 
 struct TextureCubeConfiguration {
@@ -338,20 +416,34 @@ auto loadPipeline(Device& device, uint64_t tag, std::span<const std::string_view
 auto loadTexture(Device& device, std::string_view filepath) -> void;
 auto loadModel(Device& device, std::string_view filepath) -> void;
 
-auto addMesh(Device& device, const Mesh& mesh) -> uint32_t;
-auto addMaterial(Device& device, const Material& material) -> uint32_t;
+auto addMesh(Device& device, const Mesh& mesh) -> MeshRef;
+auto addMesh(Device& device, const MeshProperty& property, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+    std::span<const Meshlet> meshlets) -> MeshRef;
+auto addMaterial(Device& device, const Material& material) -> MaterialRef;
 auto addLight(Device& device, const Light& light) -> uint32_t;
 auto addDirectionalLight(Device& device, const DirectionalLightConfiguration& conf) -> uint32_t;
 
-auto createMesh(Device& device, const CreateMeshConfiguration& conf) -> uint32_t;
-auto createMaterial(Device& device, const CreateMaterialConfiguration& conf) -> uint32_t;
+auto createMesh(Device& device, const CreateMeshConfiguration& conf) -> MeshRef;
+auto createMaterial(Device& device, const CreateMaterialConfiguration& conf) -> MaterialRef;
+
+// Takes another reference on the texture created with `contentKey`, returns an invalid texture when there is none.
+auto acquireTexture(Device& device, uint64_t contentKey) -> Texture;
+
+// Releases a reference, the texture is deleted with the last one.
+auto destroyTexture(Device& device, TextureRef ref) -> bool;
+auto destroyMesh(Device& device, MeshRef ref) -> bool;
+auto destroyMaterial(Device& device, MaterialRef ref) -> bool;
+auto destroyModel(Device& device, ModelRef ref) -> bool;
+
+// Moves a node of the model, with its subtree, in every entity of the model from the next frame on.
+auto setNodeTransform(Device& device, ModelRef ref, uint32_t node, const mat4& local) -> bool;
 
 auto findShader(Device& device, uint64_t tag) -> Shader;
 auto findPipeline(Device& device, uint64_t tag) -> Pipeline;
 auto findTexture(Device& device, uint64_t tag) -> Texture;
 auto findBuffer(Device& device, uint64_t tag) -> Buffer;
 auto findTextureHandleRef(Device& device, uint64_t handle) -> uint32_t;
-auto findModelRef(Device& device, uint64_t tag) -> uint32_t;
+auto findModelRef(Device& device, uint64_t tag) -> ModelRef;
 
 auto drawQuad(Device& device) -> void;
 auto drawCube(Device& device) -> void;
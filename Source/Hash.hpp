@@ -2,6 +2,8 @@
 
 #include <xxhash.h>
 
+#include <string_view>
+
 static inline auto make_hash(std::string_view s) -> uint64_t {
     return XXH64(std::data(s), std::size(s), 0);
 }
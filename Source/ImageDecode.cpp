@@ -0,0 +1,97 @@
+#include "ImageDecode.hpp"
+#include "Log.hpp"
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace Graphics {
+
+auto ImageDeleter::operator()(uint8_t* pixels) const -> void {
+    stbi_image_free(pixels);
+}
+
+static auto hdrFormat(int channels) -> Format {
+    switch (channels) {
+    case 3:
+        return Format::R32G32B32_FLOAT;
+    case 4:
+        return Format::R16G16B16A16_FLOAT;
+    default:
+        return Format::Undefined;
+    }
+}
+
+static auto ldrFormat(int channels) -> Format {
+    switch (channels) {
+    case 1:
+        return Format::R8_UNORM;
+    case 2:
+        return Format::R8G8_UNORM;
+    case 3:
+        return Format::R8G8B8_UNORM;
+    case 4:
+        return Format::R8G8B8A8_UNORM;
+    default:
+        return Format::Undefined;
+    }
+}
+
+auto decodeImage(std::span<const uint8_t> encoded, int channels, bool flipVertically) -> DecodedImage {
+    using clock = std::chrono::steady_clock;
+
+    const auto start = clock::now();
+
+    // the global flip flag would race between decode threads
+    stbi_set_flip_vertically_on_load_thread(flipVertically);
+
+    const auto bytes = std::data(encoded);
+    const auto length = static_cast<int>(std::size(encoded));
+
+    int width = 0, height = 0, imageChannels = 0;
+
+    DecodedImage image;
+    size_t componentSize = 1;
+
+    if (stbi_is_hdr_from_memory(bytes, length)) {
+        auto pixels = stbi_loadf_from_memory(bytes, length, &width, &height, &imageChannels, channels);
+        image.pixels.reset(reinterpret_cast<uint8_t*>(pixels));
+        componentSize = 4;
+    } else {
+        image.pixels.reset(stbi_load_from_memory(bytes, length, &width, &height, &imageChannels, channels));
+    }
+
+    if (!image.pixels) {
+        LOG_ERROR("Can't decode image: {}", stbi_failure_reason());
+        return {};
+    }
+
+    const int outputChannels = channels != 0 ? channels : imageChannels;
+
+    image.width = static_cast<uint32_t>(width);
+    image.height = static_cast<uint32_t>(height);
+    image.format = componentSize == 4 ? hdrFormat(outputChannels) : ldrFormat(outputChannels);
+    image.size = static_cast<size_t>(width) * height * outputChannels * componentSize;
+    image.decodeMilliseconds = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    return image;
+}
+
+auto decodeImageFile(std::string_view filepath, int channels, bool flipVertically) -> DecodedImage {
+    std::ifstream file { std::string { filepath }, std::ios::binary };
+    if (!file) {
+        LOG_ERROR("Can't open image {}", filepath);
+        return {};
+    }
+
+    const std::vector<uint8_t> encoded { std::istreambuf_iterator<char> { file }, std::istreambuf_iterator<char> {} };
+
+    return decodeImage(encoded, channels, flipVertically);
+}
+
+} // namespace Graphics
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Graphics.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+
+namespace Graphics {
+
+struct ImageDeleter {
+    auto operator()(uint8_t* pixels) const -> void;
+};
+
+// Pixels decoded by stb_image, ready to be handed to createTexture2D on the context thread.
+struct DecodedImage {
+    auto is_valid() const noexcept -> bool {
+        return pixels != nullptr;
+    }
+
+    operator bool() const {
+        return is_valid();
+    }
+
+    auto data() const noexcept -> std::span<const uint8_t> {
+        return { pixels.get(), size };
+    }
+
+    uint32_t width { 0 };
+    uint32_t height { 0 };
+    Format format { Format::Undefined };
+    std::unique_ptr<uint8_t, ImageDeleter> pixels;
+    size_t size { 0 };
+    double decodeMilliseconds { 0.0 };
+};
+
+// Decoding is thread safe, so these may run on any thread; `channels` 0 keeps the channel count of the image.
+auto decodeImage(std::span<const uint8_t> encoded, int channels = 0, bool flipVertically = false) -> DecodedImage;
+auto decodeImageFile(std::string_view filepath, int channels = 0, bool flipVertically = false) -> DecodedImage;
+
+// Creates the texture from decoded pixels, `conf` provides everything but the size, format and pixels. Context thread only.
+auto createTexture2D(Device& device, const DecodedImage& image, TextureConfiguration conf) -> Texture;
+
+} // namespace Graphics
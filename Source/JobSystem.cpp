@@ -0,0 +1,125 @@
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+namespace Graphics {
+
+static thread_local const JobSystem* currentJobSystem = nullptr;
+static thread_local size_t currentQueueIndex = 0;
+
+JobSystem::JobSystem(size_t threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+    }
+
+    queues_.resize(threadCount);
+    for (auto& queue : queues_) {
+        queue = std::make_unique<Queue>();
+    }
+
+    workers_.reserve(threadCount - 1);
+    for (size_t i = 1; i < threadCount; i++) {
+        workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard lock { sleepMutex_ };
+        stop_ = true;
+    }
+
+    wakeCondition_.notify_all();
+
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+auto JobSystem::schedule(JobCounter& counter, Job job) -> void {
+    counter.fetch_add(1, std::memory_order_relaxed);
+
+    auto& queue = *queues_[currentQueue()];
+    {
+        std::lock_guard lock { queue.mutex };
+        queue.tasks.push_back({ std::move(job), &counter });
+    }
+
+    {
+        std::lock_guard lock { sleepMutex_ };
+        queuedTasks_++;
+    }
+
+    wakeCondition_.notify_one();
+}
+
+auto JobSystem::wait(const JobCounter& counter) -> void {
+    const size_t queueIndex = currentQueue();
+
+    while (counter.load(std::memory_order_acquire) != 0) {
+        if (!tryRun(queueIndex)) {
+            // the remaining jobs are running on other threads
+            std::this_thread::yield();
+        }
+    }
+}
+
+auto JobSystem::workerLoop(size_t queueIndex) -> void {
+    currentJobSystem = this;
+    currentQueueIndex = queueIndex;
+
+    for (;;) {
+        if (tryRun(queueIndex)) {
+            continue;
+        }
+
+        std::unique_lock lock { sleepMutex_ };
+        wakeCondition_.wait(lock, [this] { return stop_ || queuedTasks_ != 0; });
+
+        if (stop_) {
+            return;
+        }
+    }
+}
+
+auto JobSystem::tryRun(size_t queueIndex) -> bool {
+    Task task;
+
+    {
+        auto& queue = *queues_[queueIndex];
+        std::lock_guard lock { queue.mutex };
+        if (!queue.tasks.empty()) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        }
+    }
+
+    for (size_t i = 1; !task.job && i < std::size(queues_); i++) {
+        auto& victim = *queues_[(queueIndex + i) % std::size(queues_)];
+        std::lock_guard lock { victim.mutex };
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+        }
+    }
+
+    if (!task.job) {
+        return false;
+    }
+
+    {
+        std::lock_guard lock { sleepMutex_ };
+        queuedTasks_--;
+    }
+
+    task.job();
+    task.counter->fetch_sub(1, std::memory_order_release);
+
+    return true;
+}
+
+auto JobSystem::currentQueue() const noexcept -> size_t {
+    return currentJobSystem == this ? currentQueueIndex : 0;
+}
+
+} // namespace Graphics
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Graphics {
+
+// Number of scheduled jobs that have not finished yet; `JobSystem::wait` blocks until it drops to zero.
+using JobCounter = std::atomic<size_t>;
+
+// Work-stealing thread pool for load-time work.
+// Every worker owns a queue it pops from the back (newest first, cache-hot nested jobs) while idle workers steal from the front of
+// other queues. Threads waiting on a counter run queued jobs instead of blocking, so jobs may schedule and wait on nested jobs.
+struct JobSystem {
+    using Job = std::function<void()>;
+
+    // `threadCount` includes the calling thread, 0 picks one thread per hardware core.
+    explicit JobSystem(size_t threadCount = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    auto operator=(const JobSystem&) -> JobSystem& = delete;
+
+    auto schedule(JobCounter& counter, Job job) -> void;
+    auto wait(const JobCounter& counter) -> void;
+
+    // Runs fn(i) for i in [0, count) and waits for all of them.
+    template <typename F> auto parallelFor(size_t count, F&& fn) -> void {
+        JobCounter counter { 0 };
+        for (size_t i = 0; i < count; i++) {
+            schedule(counter, [&fn, i] { fn(i); });
+        }
+
+        wait(counter);
+    }
+
+    auto threadCount() const noexcept -> size_t {
+        return std::size(workers_) + 1;
+    }
+
+private:
+    struct Task {
+        Job job;
+        JobCounter* counter { nullptr };
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    auto workerLoop(size_t queueIndex) -> void;
+    auto tryRun(size_t queueIndex) -> bool;
+    auto currentQueue() const noexcept -> size_t;
+
+    // queue 0 is shared by threads that are not workers of this system
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+
+    std::mutex sleepMutex_;
+    std::condition_variable wakeCondition_;
+    size_t queuedTasks_ { 0 };
+    bool stop_ { false };
+};
+
+} // namespace Graphics
@@ -1,22 +1,163 @@
 #include "Common.hpp"
 #include "Graphics.hpp"
 #include "Hash.hpp"
+#include "ImageDecode.hpp"
+#include "JobSystem.hpp"
 #include "Log.hpp"
+#include "MappedFile.hpp"
+#include "MeshCache.hpp"
+#include "MeshProcessing.hpp"
 #include "Renderer.hpp"
+#include "TextureBake.hpp"
+#include "TextureStreamer.hpp"
 
 #include <glad/gl.h>
-#include <meshoptimizer.h>
 #include <nlohmann/json.hpp>
 
 #define TINYGLTF_IMPLEMENTATION
 #define TINYGLTF_NO_INCLUDE_JSON
+#define TINYGLTF_NO_STB_IMAGE
 #define TINYGLTF_NO_STB_IMAGE_WRITE
 
 #include <tiny_gltf.h>
 
+#include <algorithm>
+#include <chrono>
+
 namespace Graphics {
 
-auto processTextures(Device& device, const tinygltf::Model& model) -> std::vector<Texture> {
+// Keeps the encoded bytes of every image while the glTF is parsed, so they can be decoded in parallel afterwards.
+static auto storeEncodedImage(tinygltf::Image*, const int imageIndex, std::string*, std::string*, int, int, const unsigned char* bytes,
+    int size, void* userData) -> bool {
+
+    auto& encodedImages = *static_cast<std::vector<std::vector<uint8_t>>*>(userData);
+    if (static_cast<size_t>(imageIndex) >= std::size(encodedImages)) {
+        encodedImages.resize(imageIndex + 1);
+    }
+
+    encodedImages[imageIndex].assign(bytes, bytes + size);
+
+    return true;
+}
+
+// Image of a glTF model, either mapped from its baked texture or decoded from the encoded bytes.
+struct ModelImage {
+    std::shared_ptr<const BakedTexture> baked;
+    std::shared_ptr<const DecodedImage> decoded;
+    // of the pixels as uploaded, equal images of any model share a texture
+    uint64_t contentHash { 0 };
+};
+
+// The baked file holds the format, size and every level, decoded pixels are hashed with their layout.
+static auto imageContentHash(const ModelImage& image) -> uint64_t {
+    if (image.baked) {
+        const auto bytes = image.baked->file.bytes();
+        return XXH64(std::data(bytes), std::size(bytes), 0);
+    }
+
+    const auto& decoded = *image.decoded;
+    const uint32_t layout[] = { decoded.width, decoded.height, static_cast<uint32_t>(decoded.format) };
+    const auto pixels = decoded.data();
+
+    return XXH64(std::data(pixels), std::size(pixels), XXH64(layout, sizeof(layout), 0));
+}
+
+static auto openBakedImage(std::string_view bakedPath, Format format) -> std::shared_ptr<const BakedTexture> {
+    auto texture = openBakedTexture(bakedPath);
+    if (!texture) {
+        return {};
+    }
+
+    // baked for another usage
+    if (texture.header->format != format) {
+        closeBakedTexture(texture);
+        return {};
+    }
+
+    return { new BakedTexture { texture }, [](BakedTexture* baked) {
+                closeBakedTexture(*baked);
+                delete baked;
+            } };
+}
+
+// Images without a fresh baked texture are decoded and streamed as they are; when `bake` is set they are baked on the spot
+// instead, so following loads only map them.
+static auto loadImages(JobSystem& jobs, std::string_view filepath, const tinygltf::Model& model,
+    std::span<const std::vector<uint8_t>> encodedImages, bool bake) -> std::vector<ModelImage> {
+
+    using clock = std::chrono::steady_clock;
+
+    const auto start = clock::now();
+    const auto usages = imageUsages(model);
+
+    std::vector<ModelImage> images;
+    images.resize(std::size(model.images));
+
+    std::vector<double> decodeMilliseconds(std::size(images));
+    std::vector<double> bakeMilliseconds(std::size(images));
+
+    jobs.parallelFor(std::size(images), [&](size_t i) {
+        const auto paths = imageBakePaths(filepath, model, i);
+        const auto format = textureFormat(usages[i]);
+
+        if (isBakedTextureFresh(paths)) {
+            images[i].baked = openBakedImage(paths.baked, format);
+        }
+
+        if (images[i].baked) {
+            images[i].contentHash = imageContentHash(images[i]);
+            return;
+        }
+
+        // glTF textures are always decoded as RGBA
+        auto decoded = std::make_shared<DecodedImage>(i < std::size(encodedImages) ? decodeImage(encodedImages[i], 4) : DecodedImage {});
+        decodeMilliseconds[i] = decoded->decodeMilliseconds;
+
+        if (bake && *decoded) {
+            const auto bakeStart = clock::now();
+            if (bakeTexture(jobs, *decoded, format, paths.baked)) {
+                images[i].baked = openBakedImage(paths.baked, format);
+            }
+            bakeMilliseconds[i] = std::chrono::duration<double, std::milli>(clock::now() - bakeStart).count();
+        }
+
+        if (!images[i].baked) {
+            images[i].decoded = std::move(decoded);
+        }
+        images[i].contentHash = imageContentHash(images[i]);
+    });
+
+    const auto elapsed = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+
+    double decodeTime = 0.0;
+    size_t bakedCount = 0;
+    for (size_t i = 0; i < std::size(images); i++) {
+        const auto& name = !model.images[i].name.empty() ? model.images[i].name : model.images[i].uri;
+        decodeTime += decodeMilliseconds[i];
+
+        if (const auto& baked = images[i].baked) {
+            if (bakeMilliseconds[i] != 0.0) {
+                LOG_INFO("Baked {} {}x{} with {} levels ({:.2f} ms decoding, {:.2f} ms baking)", name, baked->header->width,
+                    baked->header->height, baked->header->levelCount, decodeMilliseconds[i], bakeMilliseconds[i]);
+            } else {
+                LOG_INFO("Mapped baked {} {}x{} with {} levels", name, baked->header->width, baked->header->height,
+                    baked->header->levelCount);
+            }
+            bakedCount++;
+        } else {
+            const auto& decoded = *images[i].decoded;
+            LOG_INFO("Decoded {} {}x{} in {:.2f} ms", name, decoded.width, decoded.height, decoded.decodeMilliseconds);
+        }
+    }
+
+    LOG_INFO("Loaded {} images ({} baked) in {:.2f} ms ({:.2f} ms of decoding on {} threads)", std::size(images), bakedCount, elapsed,
+        decodeTime, jobs.threadCount());
+
+    return images;
+}
+
+// Textures are created right away and receive their pixels over the next frames through the texture streamer.
+static auto processTextures(Device& device, const tinygltf::Model& model, std::span<const ModelImage> images) -> std::vector<Texture> {
     std::vector<Texture> textures;
     textures.resize(std::size(model.textures));
 
@@ -49,41 +190,38 @@ auto processTextures(Device& device, const tinygltf::Model& model) -> std::vecto
             }
         }
 
-        [[maybe_unused]] Format pixelFormat { Format::Undefined };
-        switch (image.component) {
-        case 1:
-            pixelFormat = Format::R8_UNORM;
-            break;
-        case 2:
-            pixelFormat = Format::R8G8_UNORM;
-            break;
-        case 3:
-            pixelFormat = Format::R8G8B8_UNORM;
-            break;
-        case 4:
-            pixelFormat = Format::R8G8B8A8_UNORM;
-            break;
+        // the sampler state lives in the texture object, so it is part of what has to match
+        const auto& source = images[model.textures[i].source];
+        const uint32_t samplerState[] = { static_cast<uint32_t>(filtering), static_cast<uint32_t>(wrap), generateMipMaps };
+        const auto contentKey = XXH64(samplerState, sizeof(samplerState), source.contentHash);
+
+        if (auto shared = acquireTexture(device, contentKey)) {
+            textures[i] = shared;
+            continue;
         }
 
-        textures[i] = createTexture2D(device,
-            { .tag = make_hash(image.name),
-                .width = static_cast<uint32_t>(image.width),
-                .height = static_cast<uint32_t>(image.height),
-                .format = pixelFormat,
-                .mipLevels = 4,
-                .generateMipMaps = generateMipMaps,
-                .bindless = true,
-                .filter = filtering,
-                .wrap = wrap,
-                .pixels = image.image });
+        const TextureConfiguration conf { .tag = make_hash(image.name),
+            .mipLevels = 4,
+            .generateMipMaps = generateMipMaps,
+            .bindless = true,
+            .filter = filtering,
+            .wrap = wrap,
+            .contentKey = contentKey };
+
+        // baked textures bring their whole mip chain, only decoded ones need the driver to generate mips
+        textures[i] = source.baked ? streamTexture2D(device, source.baked, conf) : streamTexture2D(device, source.decoded, conf);
+        if (!textures[i]) {
+            LOG_ERROR("Can't create texture {} from image {}", i, model.textures[i].source);
+        }
     }
 
     return textures;
 }
 
-auto processMaterials(Device& device, const tinygltf::Model& model, std::span<const Texture> allTextures) -> std::vector<uint32_t> {
+// Texture fields of the converted materials hold glTF texture indices, addMaterials turns them into texture handle refs.
+static auto convertMaterials(const tinygltf::Model& model) -> std::vector<Material> {
 
-    std::vector<uint32_t> materials;
+    std::vector<Material> materials;
     for (size_t i = 0; i < std::size(model.materials); i++) {
         const auto& importedMaterial = model.materials[i];
 
@@ -99,25 +237,24 @@ auto processMaterials(Device& device, const tinygltf::Model& model, std::span<co
         m.pbrMetallicRoughness.roughnessFactor = importedMaterial.pbrMetallicRoughness.roughnessFactor;
 
         if (importedMaterial.pbrMetallicRoughness.baseColorTexture.index != -1) {
-            m.pbrMetallicRoughness.baseColorTexture
-                = findTextureHandleRef(device, allTextures[importedMaterial.pbrMetallicRoughness.baseColorTexture.index].handle);
+            m.pbrMetallicRoughness.baseColorTexture = static_cast<uint32_t>(importedMaterial.pbrMetallicRoughness.baseColorTexture.index);
         }
 
         if (importedMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index != -1) {
             m.pbrMetallicRoughness.metallicRoughnessTexture
-                = findTextureHandleRef(device, allTextures[importedMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index].handle);
+                = static_cast<uint32_t>(importedMaterial.pbrMetallicRoughness.metallicRoughnessTexture.index);
         }
 
         if (importedMaterial.normalTexture.index != -1) {
-            m.normalTexture = findTextureHandleRef(device, allTextures[importedMaterial.normalTexture.index].handle);
+            m.normalTexture = static_cast<uint32_t>(importedMaterial.normalTexture.index);
         }
 
         if (importedMaterial.occlusionTexture.index != -1) {
-            m.occlusionTexture = findTextureHandleRef(device, allTextures[importedMaterial.occlusionTexture.index].handle);
+            m.occlusionTexture = static_cast<uint32_t>(importedMaterial.occlusionTexture.index);
         }
 
         if (importedMaterial.emissiveTexture.index != -1) {
-            m.emissiveTexture = findTextureHandleRef(device, allTextures[importedMaterial.emissiveTexture.index].handle);
+            m.emissiveTexture = static_cast<uint32_t>(importedMaterial.emissiveTexture.index);
 
             if (m.emissiveFactor == vec3 { 0.f }) {
                 m.emissiveFactor = vec3 { 1.f };
@@ -125,13 +262,53 @@ auto processMaterials(Device& device, const tinygltf::Model& model, std::span<co
             }
         }
 
-        materials.push_back(addMaterial(device, m));
+        materials.push_back(m);
     }
 
     return materials;
 }
 
+static auto addMaterials(Device& device, std::span<const Material> materials, std::span<const Texture> allTextures)
+    -> std::vector<MaterialRef> {
+
+    const auto resolve = [&](uint32_t texture) -> uint32_t {
+        // textures whose image failed to load are left out, Mesh.frag shades unbound slots with the material factors alone
+        if (texture >= std::size(allTextures) || allTextures[texture].handle == 0) {
+            return 0xffffffff;
+        }
+
+        // an unregistered handle resolves past the end of textureHandles_, where a later texture would be registered
+        const auto ref = findTextureHandleRef(device, allTextures[texture].handle);
+        return ref < std::size(device.textureHandles_) ? ref : 0xffffffff;
+    };
+
+    std::vector<MaterialRef> refs;
+    for (auto m : materials) {
+        m.pbrMetallicRoughness.baseColorTexture = resolve(m.pbrMetallicRoughness.baseColorTexture);
+        m.pbrMetallicRoughness.metallicRoughnessTexture = resolve(m.pbrMetallicRoughness.metallicRoughnessTexture);
+        m.normalTexture = resolve(m.normalTexture);
+        m.occlusionTexture = resolve(m.occlusionTexture);
+        m.emissiveTexture = resolve(m.emissiveTexture);
+
+        refs.push_back(addMaterial(device, m));
+    }
+
+    return refs;
+}
+
 auto getNodeLocalTransformMatrix(const tinygltf::Node& node) -> mat4 {
+    // column major, like glm
+    if (std::size(node.matrix) == 16) {
+        mat4 matrix;
+        for (int c = 0; c < 4; c++) {
+            for (int r = 0; r < 4; r++) {
+                matrix[c][r] = static_cast<float>(node.matrix[c * 4 + r]);
+            }
+        }
+
+        return matrix;
+    }
+
     vec3 translation { 0.f };
     if (!node.translation.empty()) {
         translation = vec3 { static_cast<float>(node.translation[0]), static_cast<float>(node.translation[1]),
@@ -143,10 +320,11 @@ auto getNodeLocalTransformMatrix(const tinygltf::Node& node) -> mat4 {
         scale = vec3 { static_cast<float>(node.scale[0]), static_cast<float>(node.scale[1]), static_cast<float>(node.scale[2]) };
     }
 
-    quat rotation;
+    // glTF stores x, y, z, w while glm constructs from w, x, y, z
+    quat rotation { 1.f, 0.f, 0.f, 0.f };
     if (!node.rotation.empty()) {
-        rotation = quat { static_cast<float>(node.rotation[0]), static_cast<float>(node.rotation[1]), static_cast<float>(node.rotation[2]),
-            static_cast<float>(node.rotation[3]) };
+        rotation = quat { static_cast<float>(node.rotation[3]), static_cast<float>(node.rotation[0]), static_cast<float>(node.rotation[1]),
+            static_cast<float>(node.rotation[2]) };
     }
 
     auto translationMatrix = glm::translate(mat4 { 1.f }, translation);
@@ -156,275 +334,227 @@ auto getNodeLocalTransformMatrix(const tinygltf::Node& node) -> mat4 {
     return translationMatrix * rotationMatrix * scaleMatrix;
 }
 
-auto convertVertexBufferFormat(const tinygltf::Model& model, const tinygltf::Primitive& primitive) -> std::vector<Vertex> {
+static auto addSubMesh(Device& device, const MeshProperty& property, std::span<const Vertex> vertices, std::span<const uint32_t> indices,
+    std::span<const Meshlet> meshlets, MaterialRef materialRef) -> Model::SubMesh {
 
-    std::vector<vec3> positions;
-    std::vector<vec3> normals;
-    std::vector<vec2> texcoords;
+    for (size_t j = 0; j < MaxMeshLODs; j++) {
+        LOG_DEBUG("LOD{} triangles {} meshlets {} error {}", j, property.LODs[j].indexCount / 3, property.LODs[j].meshletCount,
+            property.LODs[j].error);
+    }
 
-    for (const auto& [name, accessorIndex] : primitive.attributes) {
-        const auto& accessor = model.accessors[accessorIndex];
-        const auto& bufferView = model.bufferViews[accessor.bufferView];
-        const auto& buffer = model.buffers[bufferView.buffer];
+    return { .materialRef = materialRef, .meshRef = addMesh(device, property, vertices, indices, meshlets) };
+}
 
-        const size_t totalByteOffset = accessor.byteOffset + bufferView.byteOffset;
-        const auto stride = accessor.ByteStride(bufferView);
+// Imports the node tree of the scene breadth first, which sorts it by depth, and attaches the primitives of a node's mesh to
+// the node; meshes referenced by several nodes are drawn once per node, meshes no node references are released. Models without
+// a usable scene get one root node that all primitives hang off.
+static auto importNodes(Device& device, const tinygltf::Model& gltf, int sceneIndex,
+    std::span<const std::vector<Model::SubMesh>> primitives, Model& model) -> void {
+    // glTF node and the imported parent
+    std::vector<std::pair<int, uint32_t>> queue;
+    if (sceneIndex >= 0 && static_cast<size_t>(sceneIndex) < std::size(gltf.scenes)) {
+        for (const auto root : gltf.scenes[sceneIndex].nodes) {
+            queue.emplace_back(root, NodeHierarchy::InvalidNode);
+        }
+    }
 
-        if (name == "POSITION") {
-            positions.resize(accessor.count);
+    // a node listed twice would break the depth order, glTF forbids it anyway
+    std::vector<bool> imported(std::size(gltf.nodes), false);
+    std::vector<bool> referenced(std::size(primitives), false);
 
-            if (accessor.type == TINYGLTF_TYPE_VEC3) {
-                for (size_t i = 0; i < accessor.count; i++) {
-                    positions[i] = *reinterpret_cast<const vec3*>(std::data(buffer.data) + totalByteOffset + i * stride);
-                }
-            }
-        } else if (name == "NORMAL") {
-            normals.resize(accessor.count);
+    for (size_t i = 0; i < std::size(queue); i++) {
+        const auto [nodeIndex, parent] = queue[i];
+        if (nodeIndex < 0 || static_cast<size_t>(nodeIndex) >= std::size(gltf.nodes) || imported[nodeIndex]) {
+            continue;
+        }
+        imported[nodeIndex] = true;
 
-            if (accessor.type == TINYGLTF_TYPE_VEC3) {
-                for (size_t i = 0; i < accessor.count; i++) {
-                    normals[i] = *reinterpret_cast<const vec3*>(std::data(buffer.data) + totalByteOffset + i * stride);
-                }
-            }
-        } else if (name == "TEXCOORD_0") {
-            texcoords.resize(accessor.count);
+        const auto& node = gltf.nodes[nodeIndex];
+        const auto flatIndex = addNode(model.nodes, parent, getNodeLocalTransformMatrix(node));
 
-            if (accessor.type == TINYGLTF_TYPE_VEC2) {
-                for (size_t i = 0; i < accessor.count; i++) {
-                    texcoords[i] = *reinterpret_cast<const vec2*>(std::data(buffer.data) + totalByteOffset + i * stride);
-                }
+        if (node.mesh >= 0 && static_cast<size_t>(node.mesh) < std::size(primitives)) {
+            for (auto subMesh : primitives[node.mesh]) {
+                subMesh.parent = flatIndex;
+                model.meshes.push_back(subMesh);
             }
+            referenced[node.mesh] = true;
         }
-    }
 
-    std::vector<Vertex> vertices;
-    vertices.resize(std::size(positions));
-
-    for (size_t i = 0; i < std::size(positions); i++) {
-        vertices[i].position = positions[i];
-        vertices[i].normal = normals[i];
-        vertices[i].uv = texcoords[i];
+        for (const auto child : node.children) {
+            queue.emplace_back(child, flatIndex);
+        }
     }
 
-    return vertices;
-}
-
-auto convertIndexBufferFormat(const tinygltf::Model& model, const tinygltf::Primitive& primitive) -> std::vector<uint32_t> {
+    if (model.meshes.empty()) {
+        model.nodes = {};
+        const auto root = addNode(model.nodes, NodeHierarchy::InvalidNode, mat4 { 1.f });
 
-    const int accessorIndex = primitive.indices;
-    const auto& accessor = model.accessors[accessorIndex];
-    const auto& bufferView = model.bufferViews[accessor.bufferView];
-    const auto& buffer = model.buffers[bufferView.buffer];
-
-    const size_t totalByteOffset = accessor.byteOffset + bufferView.byteOffset;
-    const auto stride = accessor.ByteStride(bufferView);
+        for (const auto& meshPrimitives : primitives) {
+            for (auto subMesh : meshPrimitives) {
+                subMesh.parent = root;
+                model.meshes.push_back(subMesh);
+                model.meshRefs.push_back(subMesh.meshRef);
+            }
+        }
 
-    std::vector<uint32_t> indices;
-    indices.resize(accessor.count);
+        return;
+    }
 
-    if (accessor.componentType == GL_UNSIGNED_INT) {
-        for (size_t i = 0; i < accessor.count; i++) {
-            indices[i] = *reinterpret_cast<const uint32_t*>(std::data(buffer.data) + totalByteOffset + i * stride);
-        }
-    } else if (accessor.componentType == GL_UNSIGNED_SHORT) {
-        for (size_t i = 0; i < accessor.count; i++) {
-            indices[i] = *reinterpret_cast<const uint16_t*>(std::data(buffer.data) + totalByteOffset + i * stride);
+    // the model keeps the reference addMesh took for every used primitive, however many nodes instance it
+    for (size_t i = 0; i < std::size(primitives); i++) {
+        for (const auto& subMesh : primitives[i]) {
+            if (referenced[i]) {
+                model.meshRefs.push_back(subMesh.meshRef);
+            } else {
+                destroyMesh(device, subMesh.meshRef);
+            }
         }
     }
-
-    return indices;
 }
 
-auto getFaces(std::span<const uint32_t> indices) -> std::vector<uvec3> {
-    std::vector<uvec3> faces;
-    faces.resize(std::size(indices) / 3);
-    for (size_t i = 0; i < std::size(faces); i++) {
-        faces[i] = uvec3 { indices[i * 3 + 0], indices[i * 3 + 1], indices[i * 3 + 2] };
-    }
-
-    return faces;
+// Material of a primitive; primitives without one, or with an index past the materials of the glTF, get the default material
+// that loadModel appends last.
+static auto primitiveMaterial(std::span<const MaterialRef> allMaterials, uint32_t material) -> MaterialRef {
+    return material < std::size(allMaterials) - 1 ? allMaterials[material] : allMaterials.back();
 }
 
-struct MeshOptimizationConf {
-    float overdrawThreshold { 1.05f };
-    bool simplify { false };
-    float simplifyThreshold { 0.2f };
-    float targetError { 0.01f };
-};
-
-static auto optimizeMesh(const std::vector<Vertex>& meshVertices, const std::vector<uint32_t>& meshIndices,
-    const MeshOptimizationConf& conf) -> std::tuple<std::vector<Vertex>, std::vector<uint32_t>> {
-
-    const size_t numIndices = std::size(meshIndices);
-    const size_t numVertices = std::size(meshVertices);
+static auto processScene(Device& device, std::span<const ProcessedMesh> meshes, std::span<const MaterialRef> allMaterials,
+    const tinygltf::Model& gltf, int sceneIndex) -> Model {
 
-    std::vector<uint32_t> remap;
-    remap.resize(numIndices);
+    // registration touches the device buffers, so it stays on the loading thread
+    std::vector<std::vector<Model::SubMesh>> primitives(std::size(gltf.meshes));
+    for (const auto& processed : meshes) {
+        primitives[processed.meshIndex].push_back(addSubMesh(device, processed.mesh.property, processed.mesh.vertices,
+            processed.mesh.indices, processed.mesh.meshlets, primitiveMaterial(allMaterials, processed.material)));
+    }
 
-    const size_t optVertexCount = meshopt_generateVertexRemap(
-        std::data(remap), std::data(meshIndices), numIndices, std::data(meshVertices), numVertices, sizeof(Vertex));
+    Model model;
+    importNodes(device, gltf, sceneIndex, primitives, model);
 
-    std::vector<uint32_t> optIndices;
-    std::vector<Vertex> optVertices;
+    return model;
+}
 
-    optIndices.resize(numIndices);
-    optVertices.resize(optVertexCount);
-    optVertices = meshVertices;
+static auto processCachedScene(Device& device, const MeshCache& cache, std::span<const MaterialRef> allMaterials,
+    const tinygltf::Model& gltf, int sceneIndex) -> Model {
+    std::vector<std::vector<Model::SubMesh>> primitives(std::size(gltf.meshes));
+    for (const auto& entry : meshCacheEntries(cache)) {
+        if (entry.meshIndex >= std::size(primitives)) {
+            continue;
+        }
 
-    meshopt_remapIndexBuffer(std::data(optIndices), std::data(meshIndices), numIndices, std::data(remap));
-    meshopt_remapVertexBuffer(std::data(optVertices), std::data(meshVertices), numVertices, sizeof(Vertex), std::data(remap));
+        primitives[entry.meshIndex].push_back(addSubMesh(device, entry.property, meshCacheVertices(cache, entry),
+            meshCacheIndices(cache, entry), meshCacheMeshlets(cache, entry), primitiveMaterial(allMaterials, entry.material)));
+    }
 
-    meshopt_optimizeVertexCache(std::data(optIndices), std::data(optIndices), numIndices, optVertexCount);
+    Model model;
+    importNodes(device, gltf, sceneIndex, primitives, model);
 
-    meshopt_optimizeOverdraw(std::data(optIndices), std::data(optIndices), numIndices, &optVertices[0].position.x, optVertexCount,
-        sizeof(Vertex), conf.overdrawThreshold);
+    return model;
+}
 
-    meshopt_optimizeVertexFetch(
-        std::data(optVertices), std::data(optIndices), numIndices, std::data(optVertices), optVertexCount, sizeof(Vertex));
+// Covers the glTF document, its buffers and the processing settings, so any change to them invalidates the baked meshes. The
+// binary chunk of a .glb and data URIs are part of the document, only buffers in separate files are hashed on their own.
+static auto meshCacheKey(std::span<const std::byte> document, const tinygltf::Model& model) -> uint64_t {
+    uint64_t key = XXH64(std::data(document), std::size(document), meshProcessingSettingsHash());
+    for (const auto& buffer : model.buffers) {
+        if (buffer.uri.empty() || buffer.uri.starts_with("data:")) {
+            continue;
+        }
 
-    if (!conf.simplify) {
-        return { optVertices, optIndices };
+        key = XXH64(std::data(buffer.data), std::size(buffer.data), key);
     }
 
-    size_t targetIndexCount = static_cast<size_t>(std::size(optIndices) * conf.simplifyThreshold);
-    float resultError = 0.f;
-
-    std::vector<uint32_t> simplifiedIndices;
-    std::vector<Vertex> simplifiedVertices;
-
-    simplifiedIndices.resize(std::size(optIndices));
-    simplifiedIndices.resize(meshopt_simplify(&simplifiedIndices[0], &optIndices[0], std::size(optIndices), &optVertices[0].position.x,
-        std::size(optVertices), sizeof(Vertex), targetIndexCount, conf.targetError, 0, &resultError));
+    return key;
+}
 
-    simplifiedVertices.resize(
-        std::size(simplifiedIndices) < std::size(optVertices) ? std::size(simplifiedIndices) : std::size(optVertices));
-    simplifiedVertices.resize(meshopt_optimizeVertexFetch(&simplifiedVertices[0], &simplifiedIndices[0], std::size(simplifiedIndices),
-        &optVertices[0], std::size(optVertices), sizeof(Vertex)));
+auto loadModel(Device& device, std::string_view filepath) -> void {
+    tinygltf::Model model;
+    tinygltf::TinyGLTF loader;
+    std::string err;
+    std::string warn;
 
-    LOG_DEBUG("{} triangles -> triangles {} ({} deviation) {}", std::size(optIndices) / 3, std::size(simplifiedIndices) / 3,
-        resultError * 100, conf.simplifyThreshold);
+    std::vector<std::vector<uint8_t>> encodedImages;
+    loader.SetImageLoader(storeEncodedImage, &encodedImages);
 
-    return { simplifiedVertices, simplifiedIndices };
-}
+    // the document is read once, the parser and the mesh cache key share the mapping
+    auto file = openMappedFile(filepath);
+    const auto baseDir = std::string { filepath.substr(0, filepath.find_last_of("/\\") + 1) };
+    const auto size = static_cast<unsigned int>(file.size);
 
-static auto calculateTangentSpace(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
-    for (size_t i = 0; i < indices.size(); i += 3) {
-        // Get the vertices of the triangle
-        vec3& v0 = vertices[indices[i]].position;
-        vec3& v1 = vertices[indices[i + 1]].position;
-        vec3& v2 = vertices[indices[i + 2]].position;
-
-        // Get the texture coordinates of the triangle
-        vec2& uv0 = vertices[indices[i]].uv;
-        vec2& uv1 = vertices[indices[i + 1]].uv;
-        vec2& uv2 = vertices[indices[i + 2]].uv;
-
-        // Calculate the edges of the triangle
-        vec3 deltaPos1 = v1 - v0;
-        vec3 deltaPos2 = v2 - v0;
-
-        // Calculate the UV differences
-        vec2 deltaUV1 = uv1 - uv0;
-        vec2 deltaUV2 = uv2 - uv0;
-
-        // Calculate the tangent and bitangent vectors
-        float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
-
-        vec3 tangent;
-        tangent.x = f * (deltaUV2.y * deltaPos1.x - deltaUV1.y * deltaPos2.x);
-        tangent.y = f * (deltaUV2.y * deltaPos1.y - deltaUV1.y * deltaPos2.y);
-        tangent.z = f * (deltaUV2.y * deltaPos1.z - deltaUV1.y * deltaPos2.z);
-        tangent = normalize(tangent);
-
-        vec3 bitangent;
-        bitangent.x = f * (-deltaUV2.x * deltaPos1.x + deltaUV1.x * deltaPos2.x);
-        bitangent.y = f * (-deltaUV2.x * deltaPos1.y + deltaUV1.x * deltaPos2.y);
-        bitangent.z = f * (-deltaUV2.x * deltaPos1.z + deltaUV1.x * deltaPos2.z);
-        bitangent = normalize(bitangent);
-
-        // Update the vertices with tangent and bitangent information
-        vertices[indices[i]].tangent += tangent;
-        vertices[indices[i + 1]].tangent += tangent;
-        vertices[indices[i + 2]].tangent += tangent;
-
-        vertices[indices[i]].tangent += bitangent;
-        vertices[indices[i + 1]].tangent += bitangent;
-        vertices[indices[i + 2]].tangent += bitangent;
+    bool ret = false;
+    auto ext = getFilePathExt(filepath);
+    if (!file) {
+        err = "failed to open the file";
+    } else if (ext == ".glb") {
+        ret = loader.LoadBinaryFromMemory(&model, &err, &warn, reinterpret_cast<const unsigned char*>(file.data), size, baseDir);
+    } else if (ext == ".gltf") {
+        ret = loader.LoadASCIIFromString(&model, &err, &warn, reinterpret_cast<const char*>(file.data), size, baseDir);
     }
 
-    // Normalize the tangent vectors for each vertex
-    for (size_t i = 0; i < vertices.size(); ++i) {
-        vertices[i].tangent = normalize(vertices[i].tangent);
+    if (!ret || !err.empty() || !warn.empty()) {
+        LOG_ERROR("{}: {} {} {}", filepath, ret, err, warn);
     }
-}
 
-static auto processScene(Device& device, const tinygltf::Model& importedModel, [[maybe_unused]] std::span<const uint32_t> allMaterials,
-    [[maybe_unused]] size_t sceneIndex) -> Model {
+    const auto cacheKey = meshCacheKey(file.bytes(), model);
+    closeMappedFile(file);
 
-    Model model;
-    for (size_t i = 0; i < std::size(importedModel.meshes); i++) {
-        auto& importedMesh = importedModel.meshes[i];
-        for (const auto& primitive : importedMesh.primitives) {
-            auto vertices = convertVertexBufferFormat(importedModel, primitive);
-            auto indices = convertIndexBufferFormat(importedModel, primitive);
+    const auto images = loadImages(*device.jobSystem_, filepath, model, encodedImages, device.bakeTexturesOnLoad);
+    encodedImages.clear();
 
-            calculateTangentSpace(vertices, indices);
+    const auto sharedTextureBytes = device.sharedTextureBytes;
+    auto textures = processTextures(device, model, images);
 
-            Mesh m;
+    const auto cachePath = std::string { filepath } + ".meshcache";
 
-            bool simplify = false;
-            float targetError = 0.01f;
-            std::array<float, MaxMeshLODs> thresholds { 0.7, 0.5, 0.2, 0.01 };
+    std::vector<MaterialRef> materials;
+    Model sceneModel;
 
-            for (size_t j = 0; j < MaxMeshLODs; j++) {
-                if (j == MaxMeshLODs - 1) {
-                    targetError = 0.01f;
-                }
+    const auto sharedMeshes = device.sharedMeshes;
+    const auto sharedMeshBytes = device.sharedMeshBytes;
 
-                auto [optVertices, optIndices] = optimizeMesh(
-                    vertices, indices, { .simplify = simplify, .simplifyThreshold = thresholds[j], .targetError = targetError });
-                m.LODs[j].vertices = optVertices;
-                m.LODs[j].faces = getFaces(optIndices);
+    const int sceneIndex = model.defaultScene >= 0 ? model.defaultScene : 0;
 
-                simplify = true;
+    if (auto cache = openMeshCache(cachePath, cacheKey)) {
+        materials = addMaterials(device, meshCacheMaterials(cache), textures);
+        materials.push_back(addMaterial(device, Material {}));
+        sceneModel = processCachedScene(device, cache, materials, model, sceneIndex);
+        closeMeshCache(cache);
+    } else {
+        const auto convertedMaterials = convertMaterials(model);
+        const auto meshes = processMeshes(*device.jobSystem_, model);
 
-                LOG_DEBUG("LOD{} triangles {}", j, std::size(optIndices) / 3);
-            }
+        materials = addMaterials(device, convertedMaterials, textures);
+        materials.push_back(addMaterial(device, Material {}));
+        sceneModel = processScene(device, meshes, materials, model, sceneIndex);
 
-            Model::SubMesh mesh;
-            mesh.meshRef = addMesh(device, m);
-            mesh.materialRef = allMaterials[i];
-            model.meshes.push_back(mesh);
-        }
+        writeMeshCache(cachePath, cacheKey, convertedMaterials, meshes);
     }
 
-    return model;
-}
+    sceneModel.tag = make_hash(filepath);
+    sceneModel.ref = device.modelSlots_.allocate();
+    sceneModel.materials = materials;
 
-auto loadModel(Device& device, std::string_view filepath) -> void {
-    tinygltf::Model model;
-    tinygltf::TinyGLTF loader;
-    std::string err;
-    std::string warn;
+    for (const auto& texture : textures) {
+        if (!texture) {
+            continue;
+        }
 
-    bool ret = false;
-    auto ext = getFilePathExt(filepath);
-    if (ext == ".glb") {
-        ret = loader.LoadBinaryFromFile(&model, &err, &warn, std::string { filepath });
-    } else if (ext == ".gltf") {
-        ret = loader.LoadASCIIFromFile(&model, &err, &warn, std::string { filepath });
+        sceneModel.textures.push_back(texture.ref);
+        sceneModel.textureBytes += texture.size;
     }
+    sceneModel.sharedTextureBytes = device.sharedTextureBytes - sharedTextureBytes;
 
-    if (!ret || !err.empty() || !warn.empty()) {
-        LOG_ERROR("{}: {} {} {}", filepath, ret, err, warn);
-    }
+    LOG_INFO("{}: {} textures, {:.2f} MiB ({:.2f} MiB shared with other textures)", filepath, std::size(textures),
+        static_cast<double>(sceneModel.textureBytes) / (1024.0 * 1024.0),
+        static_cast<double>(sceneModel.sharedTextureBytes) / (1024.0 * 1024.0));
 
-    auto textures = processTextures(device, model);
-    auto materials = processMaterials(device, model, textures);
-    auto sceneModel = processScene(device, model, materials, model.defaultScene);
-    sceneModel.tag = make_hash(filepath);
+    if (device.sharedMeshes != sharedMeshes) {
+        LOG_INFO("{}: {} meshes shared with already loaded geometry, {:.2f} MiB saved", filepath, device.sharedMeshes - sharedMeshes,
+            static_cast<double>(device.sharedMeshBytes - sharedMeshBytes) / (1024.0 * 1024.0));
+    }
 
-    device.models_.push_back(sceneModel);
+    device.modelIndex_.insert(sceneModel.tag, sceneModel.ref.index);
+    assignSlot(device.models_, sceneModel.ref.index, sceneModel);
 }
 
 } // namespace Graphics
\ No newline at end of file
@@ -1,79 +1,32 @@
 #include "Common.hpp"
 #include "Graphics.hpp"
 #include "Hash.hpp"
+#include "ImageDecode.hpp"
 #include "Log.hpp"
 
-#define STB_IMAGE_IMPLEMENTATION
-#include <stb_image.h>
+#include <cassert>
 
 namespace Graphics {
 
-auto loadTexture(Device& device, std::string_view filepath) -> void {
-
-    int width = 0, height = 0, channels = 0;
-    const int req_comp = STBI_default;
-
-    const auto ext = getFilePathExt(filepath);
-    const bool isHDRimage = ext == ".hdr";
-
-    Format format = Format::Undefined;
-    size_t componentSize = 1;
-
-    if (isHDRimage) {
-        stbi_set_flip_vertically_on_load(true);
-        auto ptr = stbi_loadf(std::data(filepath), &width, &height, &channels, req_comp);
-        assert(ptr);
-
-        componentSize = 4;
-        if (channels == 3) {
-            format = Format::R32G32B32_FLOAT;
-        } else if (channels == 4) {
-            format = Format::R16G16B16A16_FLOAT;
-        }
+auto createTexture2D(Device& device, const DecodedImage& image, TextureConfiguration conf) -> Texture {
+    conf.width = image.width;
+    conf.height = image.height;
+    conf.format = image.format;
+    conf.pixels = image.data();
 
-        const size_t size = width * height * channels * componentSize;
-
-        createTexture2D(device,
-            { .tag = make_hash(filepath),
-                .width = static_cast<uint32_t>(width),
-                .height = static_cast<uint32_t>(height),
-                .format = format,
-                .mipLevels = 4,
-                .generateMipMaps = true,
-                .bindless = false,
-                .pixels = std::span { reinterpret_cast<uint8_t*>(ptr), size } });
-
-        stbi_image_free(ptr);
-    } else {
-        stbi_set_flip_vertically_on_load(false);
-        auto ptr = stbi_load(std::data(filepath), &width, &height, &channels, req_comp);
-        assert(ptr);
-
-        componentSize = 1;
-        if (channels == 2) {
-            format = Format::R8G8_UNORM;
-        } else if (channels == 3) {
-            format = Format::R8G8B8_UNORM;
-        } else if (channels == 4) {
-            format = Format::R8G8B8A8_UNORM;
-        }
+    return createTexture2D(device, conf);
+}
 
-        const size_t size = width * height * channels * componentSize;
+auto loadTexture(Device& device, std::string_view filepath) -> void {
+    // HDR environment maps are stored bottom-up
+    const bool isHDRimage = getFilePathExt(filepath) == ".hdr";
 
-        createTexture2D(device,
-            { .tag = make_hash(filepath),
-                .width = static_cast<uint32_t>(width),
-                .height = static_cast<uint32_t>(height),
-                .format = format,
-                .mipLevels = 4,
-                .generateMipMaps = true,
-                .bindless = true,
-                .pixels = std::span { ptr, size } });
+    const auto image = decodeImageFile(filepath, 0, isHDRimage);
+    assert(image);
 
-        stbi_image_free(ptr);
-    }
+    LOG_INFO("Decoded {} {}x{} in {:.2f} ms", filepath, image.width, image.height, image.decodeMilliseconds);
 
-    stbi_set_flip_vertically_on_load(false);
+    createTexture2D(device, image, { .tag = make_hash(filepath), .mipLevels = 4, .generateMipMaps = true, .bindless = !isHDRimage });
 }
 
 } // namespace Graphics
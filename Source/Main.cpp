@@ -91,8 +91,41 @@ static void showOverlay() {
 static auto showRendererOptions() {
     ImGui::Begin("Options");
     ImGui::Checkbox("Instance culling", &device.culling);
+    ImGui::Checkbox("Occlusion culling", &device.occlusionCulling);
+    ImGui::Checkbox("Depth prepass", &device.depthPrepass);
+    ImGui::Checkbox("Merge instances", &device.mergeInstances);
+    ImGui::SliderFloat("LOD error (px)", &device.lodPixelThreshold, 0.1f, 16.f);
+    if (device.supportsDrawIndirectCount) {
+        ImGui::Checkbox("Compact draw commands", &device.compactDraws);
+    }
     ImGui::TextUnformatted(fmt::format("Draw instances: {}", device.drawInstances).c_str());
+    ImGui::TextUnformatted(fmt::format("Draw commands: {}", device.drawCommands).c_str());
     ImGui::TextUnformatted(fmt::format("Visible instances: {}", device.visibleInstances).c_str());
+    ImGui::TextUnformatted(fmt::format("Visible meshlets: {}", device.visibleMeshlets).c_str());
+    ImGui::TextUnformatted(fmt::format("Frustum culled instances: {}", device.frustumCulledInstances).c_str());
+    ImGui::TextUnformatted(
+        fmt::format("Occluded instances: {} ({} disoccluded)", device.occludedInstances, device.disoccludedInstances).c_str());
+    ImGui::TextUnformatted(fmt::format("Triangles: {}", device.renderedTriangles).c_str());
+    const auto& lodInstances = device.lodInstances;
+    ImGui::TextUnformatted(
+        fmt::format("Instances per LOD: {} / {} / {} / {}", lodInstances[0], lodInstances[1], lodInstances[2], lodInstances[3]).c_str());
+    const auto showAllocatorStats = [](const char* name, const Graphics::RangeAllocator& allocator) {
+        const auto stats = allocator.stats();
+        const auto text = fmt::format("{}: {}/{} used, {} free ranges, {:.1f}% fragmented", name, stats.usedSize, stats.capacity,
+            stats.freeRangeCount, stats.fragmentation * 100.f);
+        ImGui::TextUnformatted(text.c_str());
+    };
+    showAllocatorStats("Vertices", device.vertexAllocator_);
+    showAllocatorStats("Indices", device.indexAllocator_);
+    showAllocatorStats("Meshlets", device.meshletAllocator_);
+    ImGui::TextUnformatted(fmt::format("Shared meshes: {} ({:.2f} MiB saved)", device.sharedMeshes,
+        static_cast<double>(device.sharedMeshBytes) / (1024.0 * 1024.0)).c_str());
+    ImGui::TextUnformatted(fmt::format("Resident textures: {} ({:.2f} MiB), {} shared ({:.2f} MiB saved)", device.residentTextures,
+        static_cast<double>(device.residentTextureBytes) / (1024.0 * 1024.0), device.sharedTextures,
+        static_cast<double>(device.sharedTextureBytes) / (1024.0 * 1024.0)).c_str());
+    const auto uploads = fmt::format("Texture uploads: {} pending, {} KiB staged last frame",
+        Graphics::pendingTextureUploads(device.textureStreamer_), device.textureStreamer_.stagedBytes / 1024);
+    ImGui::TextUnformatted(uploads.c_str());
     ImGui::SliderFloat("exposure", &device.exposure, 0.f, 5.0);
     ImGui::SliderFloat("gamma", &device.gamma, 0.f, 5.0);
     ImGui::End();
@@ -161,7 +194,7 @@ int main() {
 
     constexpr int N = 2;
 
-    if (!Graphics::initialize(device, { .window = window, .numEntities = N * N * N })) {
+    if (!Graphics::initialize(device, { .window = window, .numEntities = (2 * N + 1) * (2 * N + 1) * (2 * N + 1) })) {
         glfwTerminate();
         return EXIT_FAILURE;
     }
@@ -175,23 +208,21 @@ int main() {
 
     Graphics::loadModel(device, modelName);
 
-    std::vector<Graphics::Entity> entities;
     // Graphics::Entity entity1;
     // entity1.modelRef = Graphics::findModelRef(device, make_hash(modelName));
-    // entity1.transform = glm::translate(mat4 { 1.f }, vec3(0.f));
-    // entity1.transform = glm::rotate(entity1.transform, glm::radians(90.f), vec3 { 1.f, 0.f, 0.f });
-    // entity1.transform = glm::scale(entity1.transform, vec3 { 2.f });
-    // entities.push_back(entity1);
+    // entity1.transform.rotation = glm::angleAxis(glm::radians(90.f), vec3 { 1.f, 0.f, 0.f });
+    // entity1.transform.scale = vec3 { 2.f };
+    // Graphics::createEntity(device, entity1);
     for (int x = -N; x <= N; x++) {
         for (int y = -N; y <= N; y++) {
             for (int z = -N; z <= N; z++) {
                 Graphics::Entity entity;
-                entity.transform = glm::translate(mat4 { 1.f }, vec3 { x * 1.5f, y * 1.5f, z * 1.5f });
-                entity.transform = glm::rotate(entity.transform, glm::radians(90.f), vec3 { 1.f, 0.f, 0.f });
-                entity.transform = glm::scale(entity.transform, vec3 { 0.8f });
+                entity.transform = { .position = vec3 { x * 1.5f, y * 1.5f, z * 1.5f },
+                    .rotation = glm::angleAxis(glm::radians(90.f), vec3 { 1.f, 0.f, 0.f }),
+                    .scale = vec3 { 0.8f } };
                 entity.modelRef = Graphics::findModelRef(device, make_hash(modelName));
 
-                entities.push_back(entity);
+                Graphics::createEntity(device, entity);
             }
         }
     }
@@ -203,7 +234,7 @@ int main() {
             break;
         }
 
-        Graphics::present(device, camera, entities);
+        Graphics::present(device, camera);
 
         ImGui_ImplOpenGL3_NewFrame();
         ImGui_ImplGlfw_NewFrame();
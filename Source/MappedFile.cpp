@@ -0,0 +1,99 @@
+#include "MappedFile.hpp"
+
+#include <string>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Graphics {
+
+#ifdef _WIN32
+
+auto openMappedFile(std::string_view filepath) -> MappedFile {
+    MappedFile mapped;
+
+    mapped.file = CreateFileA(std::string { filepath }.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (mapped.file == INVALID_HANDLE_VALUE) {
+        return {};
+    }
+
+    LARGE_INTEGER size {};
+    if (!GetFileSizeEx(mapped.file, &size) || size.QuadPart == 0) {
+        CloseHandle(mapped.file);
+        return {};
+    }
+
+    mapped.mapping = CreateFileMappingA(mapped.file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapped.mapping) {
+        CloseHandle(mapped.file);
+        return {};
+    }
+
+    mapped.data = static_cast<const std::byte*>(MapViewOfFile(mapped.mapping, FILE_MAP_READ, 0, 0, 0));
+    if (!mapped.data) {
+        CloseHandle(mapped.mapping);
+        CloseHandle(mapped.file);
+        return {};
+    }
+
+    mapped.size = static_cast<size_t>(size.QuadPart);
+
+    return mapped;
+}
+
+auto closeMappedFile(MappedFile& file) -> void {
+    if (file.data) {
+        UnmapViewOfFile(file.data);
+        CloseHandle(file.mapping);
+        CloseHandle(file.file);
+    }
+
+    file = {};
+}
+
+#else
+
+auto openMappedFile(std::string_view filepath) -> MappedFile {
+    const int fd = open(std::string { filepath }.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return {};
+    }
+
+    struct stat info {};
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        close(fd);
+        return {};
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // the mapping stays valid after the descriptor is closed
+    close(fd);
+
+    if (data == MAP_FAILED) {
+        return {};
+    }
+
+    return { .data = static_cast<const std::byte*>(data), .size = static_cast<size_t>(info.st_size) };
+}
+
+auto closeMappedFile(MappedFile& file) -> void {
+    if (file.data) {
+        munmap(const_cast<std::byte*>(file.data), file.size);
+    }
+
+    file = {};
+}
+
+#endif
+
+} // namespace Graphics
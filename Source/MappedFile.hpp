@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace Graphics {
+
+// Read-only memory mapping of a whole file.
+struct MappedFile {
+    auto is_valid() const noexcept -> bool {
+        return data != nullptr;
+    }
+
+    operator bool() const {
+        return is_valid();
+    }
+
+    auto bytes() const noexcept -> std::span<const std::byte> {
+        return { data, size };
+    }
+
+    const std::byte* data { nullptr };
+    size_t size { 0 };
+
+#ifdef _WIN32
+    void* file { nullptr };
+    void* mapping { nullptr };
+#endif
+};
+
+auto openMappedFile(std::string_view filepath) -> MappedFile;
+auto closeMappedFile(MappedFile& file) -> void;
+
+} // namespace Graphics
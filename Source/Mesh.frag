@@ -30,7 +30,7 @@ struct Light {
 };
 
 layout(std430, binding = 3) readonly buffer DrawablesBlock {
-    uvec2 drawables[];
+    uvec4 drawables[];
 };
 
 layout(std430, binding = 4) readonly buffer MaterialBlock {
@@ -68,9 +68,29 @@ fs_in;
 
 layout(location = 0) out vec4 FragColor;
 
+// Samples the texture of a material slot, or returns `fallback` when the slot is unbound (all bits set) or its texture was
+// released, so materials without textures shade with their factors alone.
+vec4 sampleMaterialTexture(uint textureIndex, vec2 uv, vec4 fallback) {
+    if (textureIndex >= textureHandles.length())
+        return fallback;
+
+    uvec2 handle = textureHandles[textureIndex];
+    if (handle == uvec2(0))
+        return fallback;
+
+    return texture(sampler2D(handle), uv);
+}
+
+// normal maps are baked to two channels, z is reconstructed from the unit length; (0.5, 0.5) is the unperturbed normal
+const vec4 FlatNormal = vec4(0.5, 0.5, 1.0, 1.0);
+
+vec3 unpackNormal(vec2 xy) {
+    xy = xy * 2.0 - 1.0;
+    return vec3(xy, sqrt(max(1.0 - dot(xy, xy), 0.0)));
+}
+
 vec3 getNormalFromMap(vec3 worldPos, vec3 normal, uint material_index) {
-    sampler2D normalMap = sampler2D(textureHandles[materials[material_index].normalTexture]);
-    vec3 tangentNormal = texture(normalMap, fs_in.TexCoord).xyz * 2.0 - 1.0;
+    vec3 tangentNormal = unpackNormal(sampleMaterialTexture(materials[material_index].normalTexture, fs_in.TexCoord, FlatNormal).xy);
 
     vec3 Q1 = dFdx(worldPos);
     vec3 Q2 = dFdy(worldPos);
@@ -164,22 +184,22 @@ vec3 sRGB_to_Linear(vec3 sRGBColor) {
 void main() {
     uint material_index = drawables[fs_in.drawID].x;
 
-    sampler2D baseColorMap = sampler2D(textureHandles[materials[material_index].pbrMetallicRoughness.baseColorTexture]);
-    sampler2D metallicRoughnessMap = sampler2D(textureHandles[materials[material_index].pbrMetallicRoughness.metallicRoughnessTexture]);
-    sampler2D occlusionMap = sampler2D(textureHandles[materials[material_index].occlusionTexture]);
-    sampler2D emissiveMap = sampler2D(textureHandles[materials[material_index].emissiveTexture]);
+    Material material = materials[material_index];
+    PBRMetallicRoughnessMaterial pbr = material.pbrMetallicRoughness;
+
+    // texture values scale the material factors, as glTF defines them
+    vec4 metallicRoughness = sampleMaterialTexture(pbr.metallicRoughnessTexture, fs_in.TexCoord, vec4(1.0));
 
-    vec3 albedo = texture(baseColorMap, fs_in.TexCoord).rgb;
-    float roughness = texture(metallicRoughnessMap, fs_in.TexCoord).g;
-    float metallic = texture(metallicRoughnessMap, fs_in.TexCoord).b;
-    float occlusion = texture(occlusionMap, fs_in.TexCoord).r;
-    vec3 emission = materials[material_index].emissiveFactor * sRGB_to_Linear(texture(emissiveMap, fs_in.TexCoord).rgb)
-        * materials[material_index].emissiveStrength;
+    vec3 albedo = pbr.baseColor.rgb * sampleMaterialTexture(pbr.baseColorTexture, fs_in.TexCoord, vec4(1.0)).rgb;
+    float roughness = pbr.roughnessFactor * metallicRoughness.g;
+    float metallic = pbr.metallicFactor * metallicRoughness.b;
+    float occlusion = sampleMaterialTexture(material.occlusionTexture, fs_in.TexCoord, vec4(1.0)).r;
+    vec3 emission = material.emissiveFactor * sRGB_to_Linear(sampleMaterialTexture(material.emissiveTexture, fs_in.TexCoord, vec4(1.0)).rgb)
+        * material.emissiveStrength;
 
     // vec3 N = normalize(fs_in.Normal);
     // vec3 N = getNormalFromMap(fs_in.FragPos, fs_in.Normal, material_index);
-    sampler2D normalMap = sampler2D(textureHandles[materials[material_index].normalTexture]);
-    vec3 tangentNormal = texture(normalMap, fs_in.TexCoord).xyz * 2.0 - 1.0;
+    vec3 tangentNormal = unpackNormal(sampleMaterialTexture(material.normalTexture, fs_in.TexCoord, FlatNormal).xy);
 
     vec3 N = normalize(fs_in.TBN * tangentNormal);
     vec3 V = normalize(viewPos - fs_in.FragPos);
@@ -0,0 +1,207 @@
+#include "MeshCache.hpp"
+#include "Log.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Graphics {
+
+constexpr uint64_t MeshCacheAlignment = 16;
+
+static auto alignOffset(uint64_t offset) -> uint64_t {
+    return (offset + MeshCacheAlignment - 1) & ~(MeshCacheAlignment - 1);
+}
+
+static auto sectionFits(const MappedFile& file, uint64_t offset, uint64_t count, uint64_t elementSize) -> bool {
+    return offset % MeshCacheAlignment == 0 && offset <= file.size && count <= (file.size - offset) / elementSize;
+}
+
+template <typename T> static auto section(const MeshCache& cache, uint64_t offset, uint64_t count) -> std::span<const T> {
+    return { reinterpret_cast<const T*>(cache.file.data + offset), static_cast<size_t>(count) };
+}
+
+static auto rangeFits(uint64_t first, uint64_t count, uint64_t size) -> bool {
+    return first <= size && count <= size - first;
+}
+
+// addMesh offsets the LOD and meshlet ranges and the index values into the shared buffers, so they have to stay inside the
+// entry, or draws would read other meshes or past the buffers.
+static auto isEntryValid(const MeshCache& cache, const MeshCacheEntry& entry) -> bool {
+    const auto indices = meshCacheIndices(cache, entry);
+    const auto meshlets = meshCacheMeshlets(cache, entry);
+
+    for (const auto& lod : entry.property.LODs) {
+        if (lod.baseVertex > entry.vertexCount || !rangeFits(lod.baseIndex, lod.indexCount, entry.indexCount)
+            || !rangeFits(lod.baseMeshlet, lod.meshletCount, entry.meshletCount)) {
+            return false;
+        }
+
+        for (const auto index : indices.subspan(lod.baseIndex, lod.indexCount)) {
+            if (index >= entry.vertexCount - lod.baseVertex) {
+                return false;
+            }
+        }
+
+        for (const auto& meshlet : meshlets.subspan(lod.baseMeshlet, lod.meshletCount)) {
+            if (meshlet.firstIndex < lod.baseIndex
+                || !rangeFits(meshlet.firstIndex - lod.baseIndex, meshlet.indexCount, lod.indexCount)) {
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+auto openMeshCache(std::string_view filepath, uint64_t key) -> MeshCache {
+    auto file = openMappedFile(filepath);
+    if (!file) {
+        return {};
+    }
+
+    const auto header = reinterpret_cast<const MeshCacheHeader*>(file.data);
+
+    // bounds are checked here and the ranges of every entry below, the vertices and materials are used as they are
+    const bool valid = file.size >= sizeof(MeshCacheHeader) && header->magic == MeshCacheMagic && header->version == MeshCacheVersion
+        && header->key == key && sectionFits(file, header->materialsOffset, header->materialCount, sizeof(Material))
+        && sectionFits(file, header->meshesOffset, header->meshCount, sizeof(MeshCacheEntry))
+        && sectionFits(file, header->verticesOffset, header->vertexCount, sizeof(Vertex))
+        && sectionFits(file, header->indicesOffset, header->indexCount, sizeof(uint32_t))
+        && sectionFits(file, header->meshletsOffset, header->meshletCount, sizeof(Meshlet));
+
+    if (!valid) {
+        closeMappedFile(file);
+        return {};
+    }
+
+    MeshCache cache { .file = file, .header = header };
+
+    for (const auto& entry : meshCacheEntries(cache)) {
+        if (!rangeFits(entry.firstVertex, entry.vertexCount, header->vertexCount)
+            || !rangeFits(entry.firstIndex, entry.indexCount, header->indexCount)
+            || !rangeFits(entry.firstMeshlet, entry.meshletCount, header->meshletCount) || !isEntryValid(cache, entry)) {
+            LOG_ERROR("Invalid mesh cache {}", filepath);
+            closeMeshCache(cache);
+            return {};
+        }
+    }
+
+    return cache;
+}
+
+auto closeMeshCache(MeshCache& cache) -> void {
+    closeMappedFile(cache.file);
+    cache.header = nullptr;
+}
+
+auto meshCacheMaterials(const MeshCache& cache) -> std::span<const Material> {
+    return section<Material>(cache, cache.header->materialsOffset, cache.header->materialCount);
+}
+
+auto meshCacheEntries(const MeshCache& cache) -> std::span<const MeshCacheEntry> {
+    return section<MeshCacheEntry>(cache, cache.header->meshesOffset, cache.header->meshCount);
+}
+
+auto meshCacheVertices(const MeshCache& cache, const MeshCacheEntry& entry) -> std::span<const Vertex> {
+    return section<Vertex>(cache, cache.header->verticesOffset, cache.header->vertexCount).subspan(entry.firstVertex, entry.vertexCount);
+}
+
+auto meshCacheIndices(const MeshCache& cache, const MeshCacheEntry& entry) -> std::span<const uint32_t> {
+    return section<uint32_t>(cache, cache.header->indicesOffset, cache.header->indexCount).subspan(entry.firstIndex, entry.indexCount);
+}
+
+auto meshCacheMeshlets(const MeshCache& cache, const MeshCacheEntry& entry) -> std::span<const Meshlet> {
+    return section<Meshlet>(cache, cache.header->meshletsOffset, cache.header->meshletCount)
+        .subspan(entry.firstMeshlet, entry.meshletCount);
+}
+
+auto writeMeshCache(
+    std::string_view filepath, uint64_t key, std::span<const Material> materials, std::span<const ProcessedMesh> meshes) -> bool {
+
+    MeshCacheHeader header;
+    header.key = key;
+    header.materialCount = static_cast<uint32_t>(std::size(materials));
+    header.meshCount = static_cast<uint32_t>(std::size(meshes));
+
+    std::vector<MeshCacheEntry> entries;
+    entries.reserve(std::size(meshes));
+
+    for (const auto& [meshIndex, material, mesh] : meshes) {
+        entries.push_back({ .property = mesh.property,
+            .meshIndex = static_cast<uint32_t>(meshIndex),
+            .material = material,
+            .firstVertex = static_cast<uint32_t>(header.vertexCount),
+            .vertexCount = static_cast<uint32_t>(std::size(mesh.vertices)),
+            .firstIndex = static_cast<uint32_t>(header.indexCount),
+            .indexCount = static_cast<uint32_t>(std::size(mesh.indices)),
+            .firstMeshlet = static_cast<uint32_t>(header.meshletCount),
+            .meshletCount = static_cast<uint32_t>(std::size(mesh.meshlets)) });
+
+        header.vertexCount += std::size(mesh.vertices);
+        header.indexCount += std::size(mesh.indices);
+        header.meshletCount += std::size(mesh.meshlets);
+    }
+
+    header.materialsOffset = alignOffset(sizeof(MeshCacheHeader));
+    header.meshesOffset = alignOffset(header.materialsOffset + std::size(materials) * sizeof(Material));
+    header.verticesOffset = alignOffset(header.meshesOffset + std::size(entries) * sizeof(MeshCacheEntry));
+    header.indicesOffset = alignOffset(header.verticesOffset + header.vertexCount * sizeof(Vertex));
+    header.meshletsOffset = alignOffset(header.indicesOffset + header.indexCount * sizeof(uint32_t));
+
+    // write to a temporary file first, so an interrupted bake never leaves a cache that looks valid
+    const auto tempPath = std::string { filepath } + ".tmp";
+
+    {
+        std::ofstream file { tempPath, std::ios::binary | std::ios::trunc };
+        if (!file) {
+            LOG_ERROR("Can't write mesh cache {}", tempPath);
+            return false;
+        }
+
+        const auto write = [&file](uint64_t offset, const void* data, size_t size) {
+            // zero padding up to the section offset
+            while (static_cast<uint64_t>(file.tellp()) < offset) {
+                file.put(0);
+            }
+
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        };
+
+        write(0, &header, sizeof(header));
+        write(header.materialsOffset, std::data(materials), std::size(materials) * sizeof(Material));
+        write(header.meshesOffset, std::data(entries), std::size(entries) * sizeof(MeshCacheEntry));
+
+        write(header.verticesOffset, nullptr, 0);
+        for (const auto& processed : meshes) {
+            write(0, std::data(processed.mesh.vertices), std::size(processed.mesh.vertices) * sizeof(Vertex));
+        }
+
+        write(header.indicesOffset, nullptr, 0);
+        for (const auto& processed : meshes) {
+            write(0, std::data(processed.mesh.indices), std::size(processed.mesh.indices) * sizeof(uint32_t));
+        }
+
+        write(header.meshletsOffset, nullptr, 0);
+        for (const auto& processed : meshes) {
+            write(0, std::data(processed.mesh.meshlets), std::size(processed.mesh.meshlets) * sizeof(Meshlet));
+        }
+
+        if (!file) {
+            LOG_ERROR("Can't write mesh cache {}", tempPath);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, filepath, error);
+    if (error) {
+        LOG_ERROR("Can't write mesh cache {}: {}", filepath, error.message());
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Graphics
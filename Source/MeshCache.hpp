@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Graphics.hpp"
+#include "MappedFile.hpp"
+#include "MeshProcessing.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace Graphics {
+
+constexpr uint32_t MeshCacheMagic = 0x434d474d; // "MGMC"
+constexpr uint32_t MeshCacheVersion = 5;
+
+// Baked model geometry, laid out so that a mapped file can be used in place:
+// header, materials, mesh entries, then all vertices, all indices and all meshlets. Sections start at 16 byte aligned offsets.
+struct MeshCacheHeader {
+    uint32_t magic { MeshCacheMagic };
+    uint32_t version { MeshCacheVersion };
+    uint64_t key { 0 };
+
+    uint32_t materialCount { 0 };
+    uint32_t meshCount { 0 };
+    uint64_t vertexCount { 0 };
+    uint64_t indexCount { 0 };
+    uint64_t meshletCount { 0 };
+
+    uint64_t materialsOffset { 0 };
+    uint64_t meshesOffset { 0 };
+    uint64_t verticesOffset { 0 };
+    uint64_t indicesOffset { 0 };
+    uint64_t meshletsOffset { 0 };
+};
+
+struct MeshCacheEntry {
+    // LOD base offsets are relative to firstVertex, firstIndex and firstMeshlet
+    MeshProperty property;
+    uint32_t meshIndex { 0 };
+    uint32_t material { 0xffffffff };
+    uint32_t firstVertex { 0 };
+    uint32_t vertexCount { 0 };
+    uint32_t firstIndex { 0 };
+    uint32_t indexCount { 0 };
+    uint32_t firstMeshlet { 0 };
+    uint32_t meshletCount { 0 };
+};
+
+struct MeshCache {
+    auto is_valid() const noexcept -> bool {
+        return header != nullptr;
+    }
+
+    operator bool() const {
+        return is_valid();
+    }
+
+    MappedFile file;
+    const MeshCacheHeader* header { nullptr };
+};
+
+// Maps the cache at `filepath`; the result is invalid when the file is missing, truncated or was baked for another key.
+auto openMeshCache(std::string_view filepath, uint64_t key) -> MeshCache;
+auto closeMeshCache(MeshCache& cache) -> void;
+
+// Materials store glTF texture indices in their texture fields instead of texture handle refs.
+auto meshCacheMaterials(const MeshCache& cache) -> std::span<const Material>;
+auto meshCacheEntries(const MeshCache& cache) -> std::span<const MeshCacheEntry>;
+auto meshCacheVertices(const MeshCache& cache, const MeshCacheEntry& entry) -> std::span<const Vertex>;
+auto meshCacheIndices(const MeshCache& cache, const MeshCacheEntry& entry) -> std::span<const uint32_t>;
+auto meshCacheMeshlets(const MeshCache& cache, const MeshCacheEntry& entry) -> std::span<const Meshlet>;
+
+auto writeMeshCache(
+    std::string_view filepath, uint64_t key, std::span<const Material> materials, std::span<const ProcessedMesh> meshes) -> bool;
+
+} // namespace Graphics
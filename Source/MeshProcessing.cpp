@@ -0,0 +1,385 @@
+#include "MeshProcessing.hpp"
+#include "AccessorView.hpp"
+#include "JobSystem.hpp"
+#include "Log.hpp"
+
+#include <meshoptimizer.h>
+#include <tiny_gltf.h>
+#include <xxhash.h>
+
+namespace Graphics {
+
+// Trades meshlet compactness for tighter normal cones, which makes cone culling reject more.
+constexpr float MeshletConeWeight = 0.25f;
+
+// Bumped when accessors convert to different vertices, caches of models with integer attributes baked before were wrong.
+constexpr uint32_t AccessorConversionVersion = 1;
+
+static auto getBoundingSphere(const MeshLOD& mesh) -> BoundingSphere {
+    if (mesh.vertices.empty()) {
+        return {};
+    }
+
+    vec3 minimum = mesh.vertices[0].position;
+    vec3 maximum = mesh.vertices[0].position;
+
+    for (const auto& vertex : mesh.vertices) {
+        minimum.x = std::min(minimum.x, vertex.position.x);
+        minimum.y = std::min(minimum.y, vertex.position.y);
+        minimum.z = std::min(minimum.z, vertex.position.z);
+
+        maximum.x = std::max(maximum.x, vertex.position.x);
+        maximum.y = std::max(maximum.y, vertex.position.y);
+        maximum.z = std::max(maximum.z, vertex.position.z);
+    }
+
+    vec3 center = (minimum + maximum) * 0.5f;
+
+    float radius = 0.0f;
+    for (const auto& vertex : mesh.vertices) {
+        radius = std::max(radius, length(vertex.position - center));
+    }
+
+    return { center, radius };
+}
+
+// View of an accessor in its buffer, empty for accessors without a buffer view, which would be all zeroes.
+static auto accessorView(const tinygltf::Model& model, const tinygltf::Accessor& accessor) -> AccessorView {
+    if (accessor.bufferView < 0) {
+        return {};
+    }
+
+    const auto& bufferView = model.bufferViews[accessor.bufferView];
+    const auto& buffer = model.buffers[bufferView.buffer];
+    const auto stride = accessor.ByteStride(bufferView);
+
+    if (stride <= 0) {
+        return {};
+    }
+
+    return { .data = std::data(buffer.data) + bufferView.byteOffset + accessor.byteOffset,
+        .count = accessor.count,
+        .stride = static_cast<size_t>(stride),
+        .componentType = static_cast<ComponentType>(accessor.componentType),
+        .components = static_cast<uint32_t>(tinygltf::GetNumComponentsInType(accessor.type)),
+        .normalized = accessor.normalized };
+}
+
+// Attributes are converted from whatever component type they are stored as straight into the vertices.
+static auto convertVertexBufferFormat(const tinygltf::Model& model, const tinygltf::Primitive& primitive) -> std::vector<Vertex> {
+    const auto position = primitive.attributes.find("POSITION");
+    if (position == std::end(primitive.attributes)) {
+        return {};
+    }
+
+    std::vector<Vertex> vertices;
+    vertices.resize(model.accessors[position->second].count);
+
+    if (vertices.empty()) {
+        return vertices;
+    }
+
+    const auto gather = [&](const tinygltf::Accessor& accessor, float* destination, uint32_t components) {
+        auto view = accessorView(model, accessor);
+        view.count = std::min(view.count, std::size(vertices));
+        gatherFloats(view, destination, sizeof(Vertex), components);
+    };
+
+    for (const auto& [name, accessorIndex] : primitive.attributes) {
+        const auto& accessor = model.accessors[accessorIndex];
+
+        if (name == "POSITION") {
+            gather(accessor, &vertices[0].position.x, 3);
+        } else if (name == "NORMAL") {
+            gather(accessor, &vertices[0].normal.x, 3);
+        } else if (name == "TEXCOORD_0") {
+            gather(accessor, &vertices[0].uv.x, 2);
+        }
+    }
+
+    return vertices;
+}
+
+static auto convertIndexBufferFormat(const tinygltf::Model& model, const tinygltf::Primitive& primitive) -> std::vector<uint32_t> {
+    const auto& accessor = model.accessors[primitive.indices];
+
+    std::vector<uint32_t> indices;
+    indices.resize(accessor.count);
+
+    widenIndices(accessorView(model, accessor), indices);
+
+    return indices;
+}
+
+static auto getFaces(std::span<const uint32_t> indices) -> std::vector<uvec3> {
+    std::vector<uvec3> faces;
+    faces.resize(std::size(indices) / 3);
+    for (size_t i = 0; i < std::size(faces); i++) {
+        faces[i] = uvec3 { indices[i * 3 + 0], indices[i * 3 + 1], indices[i * 3 + 2] };
+    }
+
+    return faces;
+}
+
+// Returns the optimized vertices and indices and, for simplified meshes, the object space error of the simplification.
+static auto optimizeMesh(const std::vector<Vertex>& meshVertices, const std::vector<uint32_t>& meshIndices,
+    const MeshOptimizationConf& conf) -> std::tuple<std::vector<Vertex>, std::vector<uint32_t>, float> {
+
+    const size_t numIndices = std::size(meshIndices);
+    const size_t numVertices = std::size(meshVertices);
+
+    std::vector<uint32_t> remap;
+    remap.resize(numIndices);
+
+    const size_t optVertexCount = meshopt_generateVertexRemap(
+        std::data(remap), std::data(meshIndices), numIndices, std::data(meshVertices), numVertices, sizeof(Vertex));
+
+    std::vector<uint32_t> optIndices;
+    std::vector<Vertex> optVertices;
+
+    optIndices.resize(numIndices);
+    optVertices.resize(optVertexCount);
+    optVertices = meshVertices;
+
+    meshopt_remapIndexBuffer(std::data(optIndices), std::data(meshIndices), numIndices, std::data(remap));
+    meshopt_remapVertexBuffer(std::data(optVertices), std::data(meshVertices), numVertices, sizeof(Vertex), std::data(remap));
+
+    meshopt_optimizeVertexCache(std::data(optIndices), std::data(optIndices), numIndices, optVertexCount);
+
+    meshopt_optimizeOverdraw(std::data(optIndices), std::data(optIndices), numIndices, &optVertices[0].position.x, optVertexCount,
+        sizeof(Vertex), conf.overdrawThreshold);
+
+    meshopt_optimizeVertexFetch(
+        std::data(optVertices), std::data(optIndices), numIndices, std::data(optVertices), optVertexCount, sizeof(Vertex));
+
+    if (!conf.simplify) {
+        return { optVertices, optIndices, 0.f };
+    }
+
+    size_t targetIndexCount = static_cast<size_t>(std::size(optIndices) * conf.simplifyThreshold);
+    float resultError = 0.f;
+
+    std::vector<uint32_t> simplifiedIndices;
+    std::vector<Vertex> simplifiedVertices;
+
+    simplifiedIndices.resize(std::size(optIndices));
+    simplifiedIndices.resize(meshopt_simplify(&simplifiedIndices[0], &optIndices[0], std::size(optIndices), &optVertices[0].position.x,
+        std::size(optVertices), sizeof(Vertex), targetIndexCount, conf.targetError, 0, &resultError));
+
+    simplifiedVertices.resize(
+        std::size(simplifiedIndices) < std::size(optVertices) ? std::size(simplifiedIndices) : std::size(optVertices));
+    simplifiedVertices.resize(meshopt_optimizeVertexFetch(&simplifiedVertices[0], &simplifiedIndices[0], std::size(simplifiedIndices),
+        &optVertices[0], std::size(optVertices), sizeof(Vertex)));
+
+    LOG_DEBUG("{} triangles -> triangles {} ({} deviation) {}", std::size(optIndices) / 3, std::size(simplifiedIndices) / 3,
+        resultError * 100, conf.simplifyThreshold);
+
+    // the error is relative to the mesh extents
+    const float errorScale = meshopt_simplifyScale(&optVertices[0].position.x, std::size(optVertices), sizeof(Vertex));
+
+    return { simplifiedVertices, simplifiedIndices, resultError * errorScale };
+}
+
+static auto calculateTangentSpace(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices) {
+    for (size_t i = 0; i < indices.size(); i += 3) {
+        // Get the vertices of the triangle
+        vec3& v0 = vertices[indices[i]].position;
+        vec3& v1 = vertices[indices[i + 1]].position;
+        vec3& v2 = vertices[indices[i + 2]].position;
+
+        // Get the texture coordinates of the triangle
+        vec2& uv0 = vertices[indices[i]].uv;
+        vec2& uv1 = vertices[indices[i + 1]].uv;
+        vec2& uv2 = vertices[indices[i + 2]].uv;
+
+        // Calculate the edges of the triangle
+        vec3 deltaPos1 = v1 - v0;
+        vec3 deltaPos2 = v2 - v0;
+
+        // Calculate the UV differences
+        vec2 deltaUV1 = uv1 - uv0;
+        vec2 deltaUV2 = uv2 - uv0;
+
+        // Calculate the tangent and bitangent vectors
+        float f = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV2.x * deltaUV1.y);
+
+        vec3 tangent;
+        tangent.x = f * (deltaUV2.y * deltaPos1.x - deltaUV1.y * deltaPos2.x);
+        tangent.y = f * (deltaUV2.y * deltaPos1.y - deltaUV1.y * deltaPos2.y);
+        tangent.z = f * (deltaUV2.y * deltaPos1.z - deltaUV1.y * deltaPos2.z);
+        tangent = normalize(tangent);
+
+        vec3 bitangent;
+        bitangent.x = f * (-deltaUV2.x * deltaPos1.x + deltaUV1.x * deltaPos2.x);
+        bitangent.y = f * (-deltaUV2.x * deltaPos1.y + deltaUV1.x * deltaPos2.y);
+        bitangent.z = f * (-deltaUV2.x * deltaPos1.z + deltaUV1.x * deltaPos2.z);
+        bitangent = normalize(bitangent);
+
+        // Update the vertices with tangent and bitangent information
+        vertices[indices[i]].tangent += tangent;
+        vertices[indices[i + 1]].tangent += tangent;
+        vertices[indices[i + 2]].tangent += tangent;
+
+        vertices[indices[i]].tangent += bitangent;
+        vertices[indices[i + 1]].tangent += bitangent;
+        vertices[indices[i + 2]].tangent += bitangent;
+    }
+
+    // Normalize the tangent vectors for each vertex
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i].tangent = normalize(vertices[i].tangent);
+    }
+}
+
+// Splits one LOD into meshlets and reorders its indices so that every meshlet is a contiguous range of them.
+static auto buildMeshlets(std::span<const Vertex> vertices, std::vector<uint32_t>& indices) -> std::vector<Meshlet> {
+    if (indices.empty()) {
+        return {};
+    }
+
+    const size_t maxMeshlets = meshopt_buildMeshletsBound(std::size(indices), MaxMeshletVertices, MaxMeshletTriangles);
+
+    std::vector<meshopt_Meshlet> meshlets(maxMeshlets);
+    std::vector<uint32_t> meshletVertices(maxMeshlets * MaxMeshletVertices);
+    std::vector<uint8_t> meshletTriangles(maxMeshlets * MaxMeshletTriangles * 3);
+
+    meshlets.resize(meshopt_buildMeshlets(std::data(meshlets), std::data(meshletVertices), std::data(meshletTriangles), std::data(indices),
+        std::size(indices), &vertices[0].position.x, std::size(vertices), sizeof(Vertex), MaxMeshletVertices, MaxMeshletTriangles,
+        MeshletConeWeight));
+
+    std::vector<Meshlet> result;
+    result.reserve(std::size(meshlets));
+
+    std::vector<uint32_t> reordered;
+    reordered.reserve(std::size(indices));
+
+    for (const auto& meshlet : meshlets) {
+        const auto bounds = meshopt_computeMeshletBounds(std::data(meshletVertices) + meshlet.vertex_offset,
+            std::data(meshletTriangles) + meshlet.triangle_offset, meshlet.triangle_count, &vertices[0].position.x, std::size(vertices),
+            sizeof(Vertex));
+
+        result.push_back({ .bounds = { vec3 { bounds.center[0], bounds.center[1], bounds.center[2] }, bounds.radius },
+            .coneApex = vec4 { bounds.cone_apex[0], bounds.cone_apex[1], bounds.cone_apex[2], 0.f },
+            .cone = vec4 { bounds.cone_axis[0], bounds.cone_axis[1], bounds.cone_axis[2], bounds.cone_cutoff },
+            .firstIndex = static_cast<uint32_t>(std::size(reordered)),
+            .indexCount = meshlet.triangle_count * 3 });
+
+        for (uint32_t i = 0; i < meshlet.triangle_count * 3; i++) {
+            reordered.push_back(meshletVertices[meshlet.vertex_offset + meshletTriangles[meshlet.triangle_offset + i]]);
+        }
+    }
+
+    indices = std::move(reordered);
+
+    return result;
+}
+
+auto lodOptimizationConf(size_t lod) -> MeshOptimizationConf {
+    return { .simplify = lod != 0, .simplifyThreshold = LODThresholds[lod], .targetError = 0.01f };
+}
+
+auto meshProcessingSettingsHash() -> uint64_t {
+    std::vector<float> settings;
+    for (size_t j = 0; j < MaxMeshLODs; j++) {
+        const auto conf = lodOptimizationConf(j);
+        settings.insert(
+            std::end(settings), { conf.overdrawThreshold, conf.simplify ? 1.f : 0.f, conf.simplifyThreshold, conf.targetError });
+    }
+
+    settings.insert(std::end(settings),
+        { static_cast<float>(MaxMeshletVertices), static_cast<float>(MaxMeshletTriangles), MeshletConeWeight,
+            static_cast<float>(AccessorConversionVersion) });
+
+    return XXH64(std::data(settings), std::size(settings) * sizeof(float), sizeof(Vertex));
+}
+
+auto packMesh(const Mesh& mesh) -> PackedMesh {
+    PackedMesh packed;
+
+    size_t idx = 0;
+    for (const auto& lod : mesh.LODs) {
+        uint32_t elementCount = std::size(lod.faces) * 3;
+
+        packed.property.LODs[idx].baseVertex = std::size(packed.vertices);
+        packed.property.LODs[idx].baseIndex = std::size(packed.indices);
+        packed.property.LODs[idx].indexCount = elementCount;
+        packed.property.LODs[idx].baseMeshlet = std::size(packed.meshlets);
+        packed.property.LODs[idx].error = lod.error;
+
+        if (elementCount == 0) {
+            continue;
+        }
+
+        packed.vertices.insert(std::end(packed.vertices), std::begin(lod.vertices), std::end(lod.vertices));
+
+        std::vector<uint32_t> indices;
+        indices.reserve(elementCount);
+        for (const auto& face : lod.faces) {
+            indices.push_back(face.x);
+            indices.push_back(face.y);
+            indices.push_back(face.z);
+        }
+
+        const auto meshlets = buildMeshlets(lod.vertices, indices);
+        packed.property.LODs[idx].meshletCount = std::size(meshlets);
+
+        for (auto meshlet : meshlets) {
+            meshlet.firstIndex += std::size(packed.indices);
+            packed.meshlets.push_back(meshlet);
+        }
+
+        packed.indices.insert(std::end(packed.indices), std::begin(indices), std::end(indices));
+
+        idx++;
+    }
+
+    packed.property.bSphere = getBoundingSphere(mesh.LODs[0]);
+
+    return packed;
+}
+
+auto processMeshes(JobSystem& jobs, const tinygltf::Model& model) -> std::vector<ProcessedMesh> {
+    std::vector<ProcessedMesh> meshes;
+    std::vector<const tinygltf::Primitive*> primitives;
+
+    for (size_t i = 0; i < std::size(model.meshes); i++) {
+        for (const auto& primitive : model.meshes[i].primitives) {
+            auto& processed = meshes.emplace_back();
+            processed.meshIndex = i;
+            processed.material = static_cast<uint32_t>(primitive.material);
+            primitives.push_back(&primitive);
+        }
+    }
+
+    JobCounter counter { 0 };
+    for (size_t i = 0; i < std::size(meshes); i++) {
+        jobs.schedule(counter, [&, i] {
+            auto vertices = convertVertexBufferFormat(model, *primitives[i]);
+            auto indices = convertIndexBufferFormat(model, *primitives[i]);
+
+            calculateTangentSpace(vertices, indices);
+
+            // every LOD is built from the full mesh, so they can be optimized in parallel
+            Mesh mesh;
+            JobCounter lodCounter { 0 };
+            for (size_t j = 0; j < MaxMeshLODs; j++) {
+                jobs.schedule(lodCounter, [&, j] {
+                    auto [optVertices, optIndices, error] = optimizeMesh(vertices, indices, lodOptimizationConf(j));
+                    mesh.LODs[j].vertices = std::move(optVertices);
+                    mesh.LODs[j].faces = getFaces(optIndices);
+                    mesh.LODs[j].error = error;
+                });
+            }
+
+            jobs.wait(lodCounter);
+
+            meshes[i].mesh = packMesh(mesh);
+        });
+    }
+
+    jobs.wait(counter);
+
+    return meshes;
+}
+
+} // namespace Graphics
@@ -0,0 +1,45 @@
+#pragma once
+
+#include "Graphics.hpp"
+
+#include <array>
+#include <vector>
+
+namespace tinygltf {
+class Model;
+}
+
+namespace Graphics {
+
+struct JobSystem;
+
+struct MeshOptimizationConf {
+    float overdrawThreshold { 1.05f };
+    bool simplify { false };
+    float simplifyThreshold { 0.2f };
+    float targetError { 0.01f };
+};
+
+// Share of the triangles each LOD keeps; LOD 0 is optimized without simplification.
+constexpr std::array<float, MaxMeshLODs> LODThresholds { 0.7f, 0.5f, 0.2f, 0.01f };
+
+struct ProcessedMesh {
+    // glTF mesh the primitive belongs to
+    size_t meshIndex { 0 };
+    // glTF material of the primitive, all bits set when it has none
+    uint32_t material { 0xffffffff };
+    PackedMesh mesh;
+};
+
+auto lodOptimizationConf(size_t lod) -> MeshOptimizationConf;
+
+// Hash of everything that affects processed geometry besides the source data, part of the baked mesh cache key.
+auto meshProcessingSettingsHash() -> uint64_t;
+
+auto packMesh(const Mesh& mesh) -> PackedMesh;
+
+// Converts, builds tangents for and optimizes every primitive of the model with all of its LODs, in glTF primitive order.
+// Runs on the job system and does not touch the device, so the caller registers the results with addMesh.
+auto processMeshes(JobSystem& jobs, const tinygltf::Model& model) -> std::vector<ProcessedMesh>;
+
+} // namespace Graphics
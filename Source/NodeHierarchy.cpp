@@ -0,0 +1,86 @@
+#include "NodeHierarchy.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Graphics {
+
+// Nodes of a level one job propagates, levels that are not larger are propagated on the calling thread.
+constexpr uint32_t PropagationBatchSize = 1024;
+
+static auto nodeDepth(const NodeHierarchy& hierarchy, uint32_t node) -> size_t {
+    const auto level = std::upper_bound(std::begin(hierarchy.levels), std::end(hierarchy.levels), node);
+
+    return static_cast<size_t>(std::distance(std::begin(hierarchy.levels), level)) - 1;
+}
+
+auto addNode(NodeHierarchy& hierarchy, uint32_t parent, const mat4& local) -> uint32_t {
+    const auto node = static_cast<uint32_t>(hierarchy.size());
+    const size_t depth = parent != NodeHierarchy::InvalidNode ? nodeDepth(hierarchy, parent) + 1 : 0;
+
+    // a node may only start the next level or extend the last one
+    assert(depth + 1 >= std::size(hierarchy.levels) && depth <= std::size(hierarchy.levels));
+    if (depth == std::size(hierarchy.levels)) {
+        hierarchy.levels.push_back(node);
+    }
+
+    hierarchy.parents.push_back(parent);
+    hierarchy.locals.push_back(local);
+    hierarchy.worlds.push_back(local);
+    hierarchy.dirty.push_back(1);
+    hierarchy.anyDirty = true;
+
+    return node;
+}
+
+auto setLocalTransform(NodeHierarchy& hierarchy, uint32_t node, const mat4& local) -> void {
+    hierarchy.locals[node] = local;
+    hierarchy.dirty[node] = 1;
+    hierarchy.anyDirty = true;
+}
+
+auto propagateTransforms(JobSystem& jobs, NodeHierarchy& hierarchy) -> bool {
+    if (!hierarchy.anyDirty) {
+        return false;
+    }
+
+    // parents are final once their level is done, so the nodes of a level only read what no one writes anymore
+    const auto propagate = [&hierarchy](uint32_t first, uint32_t last) {
+        for (uint32_t node = first; node < last; node++) {
+            const uint32_t parent = hierarchy.parents[node];
+            if (parent != NodeHierarchy::InvalidNode && hierarchy.dirty[parent]) {
+                hierarchy.dirty[node] = 1;
+            }
+
+            if (hierarchy.dirty[node]) {
+                hierarchy.worlds[node]
+                    = parent != NodeHierarchy::InvalidNode ? hierarchy.worlds[parent] * hierarchy.locals[node] : hierarchy.locals[node];
+            }
+        }
+    };
+
+    const auto nodeCount = static_cast<uint32_t>(hierarchy.size());
+    for (size_t level = 0; level < std::size(hierarchy.levels); level++) {
+        const uint32_t first = hierarchy.levels[level];
+        const uint32_t last = level + 1 < std::size(hierarchy.levels) ? hierarchy.levels[level + 1] : nodeCount;
+
+        if (last - first <= PropagationBatchSize) {
+            propagate(first, last);
+            continue;
+        }
+
+        const uint32_t batchCount = (last - first + PropagationBatchSize - 1) / PropagationBatchSize;
+        jobs.parallelFor(batchCount, [&](size_t batch) {
+            const auto batchFirst = first + static_cast<uint32_t>(batch) * PropagationBatchSize;
+            propagate(batchFirst, std::min(batchFirst + PropagationBatchSize, last));
+        });
+    }
+
+    std::fill(std::begin(hierarchy.dirty), std::end(hierarchy.dirty), uint8_t { 0 });
+    hierarchy.anyDirty = false;
+
+    return true;
+}
+
+} // namespace Graphics
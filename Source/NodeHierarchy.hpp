@@ -0,0 +1,39 @@
+#pragma once
+
+#include "Math.hpp"
+
+#include <cstdint>
+#include <vector>
+
+namespace Graphics {
+
+struct JobSystem;
+
+// Transform hierarchy flattened into arrays sorted by depth, so that every parent comes before its children and a level can
+// be propagated in parallel once the level above it is done.
+struct NodeHierarchy {
+    static constexpr uint32_t InvalidNode = 0xffffffff;
+
+    auto size() const noexcept -> size_t {
+        return std::size(parents);
+    }
+
+    std::vector<uint32_t> parents;
+    std::vector<mat4> locals;
+    std::vector<mat4> worlds;
+    // first node of every depth
+    std::vector<uint32_t> levels;
+    // nodes whose local transform changed since the last propagation, their subtrees are updated with them
+    std::vector<uint8_t> dirty;
+    bool anyDirty { false };
+};
+
+// Appends a node one level below `parent`, or a root when it is InvalidNode. Nodes have to be added level by level.
+auto addNode(NodeHierarchy& hierarchy, uint32_t parent, const mat4& local) -> uint32_t;
+
+auto setLocalTransform(NodeHierarchy& hierarchy, uint32_t node, const mat4& local) -> void;
+
+// Recomputes the world transforms of the dirty nodes and of everything below them. Returns whether any node changed.
+auto propagateTransforms(JobSystem& jobs, NodeHierarchy& hierarchy) -> bool;
+
+} // namespace Graphics
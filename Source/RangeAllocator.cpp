@@ -0,0 +1,265 @@
+#include "RangeAllocator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+
+namespace Graphics {
+
+constexpr uint32_t MantissaBits = 3;
+constexpr uint32_t MantissaValue = 1 << MantissaBits;
+constexpr uint32_t MantissaMask = MantissaValue - 1;
+
+// Size class of the smallest bin whose ranges are all at least `size` elements.
+static auto binRoundUp(uint32_t size) -> uint32_t {
+    if (size < MantissaValue) {
+        return size;
+    }
+
+    const uint32_t mantissaStart = 31 - std::countl_zero(size) - MantissaBits;
+    uint32_t mantissa = (size >> mantissaStart) & MantissaMask;
+    if (size & ((1u << mantissaStart) - 1)) {
+        mantissa++;
+    }
+
+    // a mantissa overflow carries into the exponent
+    return ((mantissaStart + 1) << MantissaBits) + mantissa;
+}
+
+// Size class a free range of `size` elements is stored in.
+static auto binRoundDown(uint32_t size) -> uint32_t {
+    if (size < MantissaValue) {
+        return size;
+    }
+
+    const uint32_t mantissaStart = 31 - std::countl_zero(size) - MantissaBits;
+    const uint32_t mantissa = (size >> mantissaStart) & MantissaMask;
+
+    return ((mantissaStart + 1) << MantissaBits) + mantissa;
+}
+
+auto RangeAllocator::allocate(uint32_t size) -> RangeAllocation {
+    if (size == 0) {
+        return {};
+    }
+
+    const uint32_t minBin = binRoundUp(size);
+    const uint32_t minTopBin = minBin / LeafBinCount;
+    const uint32_t minLeafBin = minBin % LeafBinCount;
+
+    uint32_t bin = InvalidNode;
+
+    if (usedTopBins_ & (1u << minTopBin)) {
+        if (const uint32_t leafMask = usedLeafBins_[minTopBin] & (0xffu << minLeafBin) & 0xffu; leafMask != 0) {
+            bin = minTopBin * LeafBinCount + std::countr_zero(leafMask);
+        }
+    }
+
+    if (bin == InvalidNode) {
+        const uint32_t topMask = minTopBin + 1 < TopBinCount ? usedTopBins_ & (~0u << (minTopBin + 1)) : 0;
+        if (topMask == 0) {
+            return {};
+        }
+
+        const uint32_t topBin = std::countr_zero(topMask);
+        bin = topBin * LeafBinCount + std::countr_zero(static_cast<uint32_t>(usedLeafBins_[topBin]));
+    }
+
+    const uint32_t nodeIndex = binHeads_[bin];
+    removeFromBin(nodeIndex);
+
+    const uint32_t totalSize = nodes_[nodeIndex].size;
+    nodes_[nodeIndex].size = size;
+    nodes_[nodeIndex].used = true;
+    allocationCount_++;
+
+    if (totalSize > size) {
+        const uint32_t remainderIndex = newNode();
+
+        auto& remainder = nodes_[remainderIndex];
+        auto& node = nodes_[nodeIndex];
+
+        remainder.offset = node.offset + size;
+        remainder.size = totalSize - size;
+        remainder.neighborPrev = nodeIndex;
+        remainder.neighborNext = node.neighborNext;
+
+        if (node.neighborNext != InvalidNode) {
+            nodes_[node.neighborNext].neighborPrev = remainderIndex;
+        } else {
+            lastNode_ = remainderIndex;
+        }
+
+        node.neighborNext = remainderIndex;
+
+        addToBin(remainderIndex);
+    }
+
+    return { nodes_[nodeIndex].offset, size, nodeIndex };
+}
+
+auto RangeAllocator::free(const RangeAllocation& allocation) -> void {
+    if (!allocation) {
+        return;
+    }
+
+    const uint32_t nodeIndex = allocation.node;
+    assert(nodeIndex < std::size(nodes_) && nodes_[nodeIndex].used);
+
+    nodes_[nodeIndex].used = false;
+    allocationCount_--;
+
+    if (const uint32_t prev = nodes_[nodeIndex].neighborPrev; prev != InvalidNode && !nodes_[prev].used) {
+        removeFromBin(prev);
+
+        nodes_[nodeIndex].offset = nodes_[prev].offset;
+        nodes_[nodeIndex].size += nodes_[prev].size;
+        nodes_[nodeIndex].neighborPrev = nodes_[prev].neighborPrev;
+
+        freeNodes_.push_back(prev);
+    }
+
+    if (const uint32_t next = nodes_[nodeIndex].neighborNext; next != InvalidNode && !nodes_[next].used) {
+        removeFromBin(next);
+
+        nodes_[nodeIndex].size += nodes_[next].size;
+        nodes_[nodeIndex].neighborNext = nodes_[next].neighborNext;
+
+        freeNodes_.push_back(next);
+    }
+
+    if (const uint32_t prev = nodes_[nodeIndex].neighborPrev; prev != InvalidNode) {
+        nodes_[prev].neighborNext = nodeIndex;
+    }
+
+    if (const uint32_t next = nodes_[nodeIndex].neighborNext; next != InvalidNode) {
+        nodes_[next].neighborPrev = nodeIndex;
+    } else {
+        lastNode_ = nodeIndex;
+    }
+
+    addToBin(nodeIndex);
+}
+
+auto RangeAllocator::grow(uint32_t capacity) -> void {
+    if (capacity <= capacity_) {
+        return;
+    }
+
+    const uint32_t extra = capacity - capacity_;
+
+    if (lastNode_ != InvalidNode && !nodes_[lastNode_].used) {
+        removeFromBin(lastNode_);
+        nodes_[lastNode_].size += extra;
+        addToBin(lastNode_);
+    } else {
+        const uint32_t nodeIndex = newNode();
+
+        nodes_[nodeIndex].offset = capacity_;
+        nodes_[nodeIndex].size = extra;
+        nodes_[nodeIndex].neighborPrev = lastNode_;
+
+        if (lastNode_ != InvalidNode) {
+            nodes_[lastNode_].neighborNext = nodeIndex;
+        }
+
+        lastNode_ = nodeIndex;
+
+        addToBin(nodeIndex);
+    }
+
+    capacity_ = capacity;
+}
+
+auto RangeAllocator::stats() const -> RangeAllocatorStats {
+    uint32_t largestFreeRange = 0;
+
+    if (usedTopBins_ != 0) {
+        // free ranges are binned by rounded-down size, so the largest one is in the highest used bin
+        const uint32_t topBin = 31 - std::countl_zero(usedTopBins_);
+        const uint32_t leafBin = 31 - std::countl_zero(static_cast<uint32_t>(usedLeafBins_[topBin]));
+
+        for (uint32_t node = binHeads_[topBin * LeafBinCount + leafBin]; node != InvalidNode; node = nodes_[node].binNext) {
+            largestFreeRange = std::max(largestFreeRange, nodes_[node].size);
+        }
+    }
+
+    return { .capacity = capacity_,
+        .usedSize = capacity_ - freeSize_,
+        .freeSize = freeSize_,
+        .largestFreeRange = largestFreeRange,
+        .freeRangeCount = freeRangeCount_,
+        .allocationCount = allocationCount_,
+        .fragmentation = freeSize_ != 0 ? 1.f - static_cast<float>(largestFreeRange) / static_cast<float>(freeSize_) : 0.f };
+}
+
+auto RangeAllocator::newNode() -> uint32_t {
+    if (!freeNodes_.empty()) {
+        const uint32_t nodeIndex = freeNodes_.back();
+        freeNodes_.pop_back();
+
+        nodes_[nodeIndex] = {};
+
+        return nodeIndex;
+    }
+
+    nodes_.emplace_back();
+
+    return static_cast<uint32_t>(std::size(nodes_) - 1);
+}
+
+auto RangeAllocator::addToBin(uint32_t nodeIndex) -> void {
+    auto& node = nodes_[nodeIndex];
+
+    const uint32_t bin = binRoundDown(node.size);
+    const uint32_t topBin = bin / LeafBinCount;
+    const uint32_t leafBin = bin % LeafBinCount;
+
+    node.binPrev = InvalidNode;
+    node.binNext = binHeads_[bin];
+
+    if (binHeads_[bin] != InvalidNode) {
+        nodes_[binHeads_[bin]].binPrev = nodeIndex;
+    }
+
+    binHeads_[bin] = nodeIndex;
+
+    usedTopBins_ |= 1u << topBin;
+    usedLeafBins_[topBin] |= static_cast<uint8_t>(1u << leafBin);
+
+    freeSize_ += node.size;
+    freeRangeCount_++;
+}
+
+auto RangeAllocator::removeFromBin(uint32_t nodeIndex) -> void {
+    auto& node = nodes_[nodeIndex];
+
+    if (node.binPrev != InvalidNode) {
+        nodes_[node.binPrev].binNext = node.binNext;
+    } else {
+        const uint32_t bin = binRoundDown(node.size);
+        const uint32_t topBin = bin / LeafBinCount;
+        const uint32_t leafBin = bin % LeafBinCount;
+
+        binHeads_[bin] = node.binNext;
+
+        if (node.binNext == InvalidNode) {
+            usedLeafBins_[topBin] &= static_cast<uint8_t>(~(1u << leafBin));
+            if (usedLeafBins_[topBin] == 0) {
+                usedTopBins_ &= ~(1u << topBin);
+            }
+        }
+    }
+
+    if (node.binNext != InvalidNode) {
+        nodes_[node.binNext].binPrev = node.binPrev;
+    }
+
+    node.binPrev = InvalidNode;
+    node.binNext = InvalidNode;
+
+    freeSize_ -= node.size;
+    freeRangeCount_--;
+}
+
+} // namespace Graphics
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace Graphics {
+
+struct RangeAllocation {
+    static constexpr uint32_t InvalidOffset = 0xffffffff;
+
+    auto is_valid() const noexcept -> bool {
+        return offset != InvalidOffset;
+    }
+
+    operator bool() const {
+        return is_valid();
+    }
+
+    uint32_t offset { InvalidOffset };
+    uint32_t size { 0 };
+    uint32_t node { 0xffffffff };
+};
+
+struct RangeAllocatorStats {
+    uint32_t capacity { 0 };
+    uint32_t usedSize { 0 };
+    uint32_t freeSize { 0 };
+    uint32_t largestFreeRange { 0 };
+    uint32_t freeRangeCount { 0 };
+    uint32_t allocationCount { 0 };
+    // 0 when all free space is one contiguous range, approaching 1 as it gets split into small holes
+    float fragmentation { 0.f };
+};
+
+// TLSF-style allocator of element ranges inside a big GPU buffer.
+// Free ranges are kept in 256 size classes (5 bit exponent, 3 bit mantissa) with two-level bitmasks, so allocation and release are O(1).
+// Released ranges are merged with free neighbours, so meshes can be added and removed without repacking the buffer.
+struct RangeAllocator {
+    auto allocate(uint32_t size) -> RangeAllocation;
+    auto free(const RangeAllocation& allocation) -> void;
+
+    // Appends free space at the end, merging it with a trailing free range.
+    auto grow(uint32_t capacity) -> void;
+
+    auto capacity() const noexcept -> uint32_t {
+        return capacity_;
+    }
+
+    auto stats() const -> RangeAllocatorStats;
+
+private:
+    static constexpr uint32_t TopBinCount = 32;
+    static constexpr uint32_t LeafBinCount = 8;
+    static constexpr uint32_t BinCount = TopBinCount * LeafBinCount;
+    static constexpr uint32_t InvalidNode = 0xffffffff;
+
+    struct Node {
+        uint32_t offset { 0 };
+        uint32_t size { 0 };
+        uint32_t binPrev { InvalidNode };
+        uint32_t binNext { InvalidNode };
+        uint32_t neighborPrev { InvalidNode };
+        uint32_t neighborNext { InvalidNode };
+        bool used { false };
+    };
+
+    auto newNode() -> uint32_t;
+    auto addToBin(uint32_t node) -> void;
+    auto removeFromBin(uint32_t node) -> void;
+
+    uint32_t capacity_ { 0 };
+    uint32_t freeSize_ { 0 };
+    uint32_t freeRangeCount_ { 0 };
+    uint32_t allocationCount_ { 0 };
+    uint32_t lastNode_ { InvalidNode };
+
+    uint32_t usedTopBins_ { 0 };
+    std::array<uint8_t, TopBinCount> usedLeafBins_ {};
+    std::array<uint32_t, BinCount> binHeads_ = [] {
+        std::array<uint32_t, BinCount> heads;
+        heads.fill(InvalidNode);
+        return heads;
+    }();
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> freeNodes_;
+};
+
+// Allocates `size` elements from a mega-buffer allocator, growing it and its CPU mirrors when no free range fits.
+template <typename... T>
+inline auto allocateRange(RangeAllocator& allocator, uint32_t size, std::vector<T>&... mirrors) -> RangeAllocation {
+    auto allocation = allocator.allocate(size);
+
+    if (!allocation && size != 0) {
+        allocator.grow(std::max(allocator.capacity() * 2, allocator.capacity() + size));
+        allocation = allocator.allocate(size);
+    }
+
+    // unused when the allocator has no mirrors
+    [[maybe_unused]] const auto growMirror = [&allocator](auto& mirror) {
+        if (std::size(mirror) < allocator.capacity()) {
+            mirror.resize(allocator.capacity());
+        }
+    };
+    (growMirror(mirrors), ...);
+
+    return allocation;
+}
+
+} // namespace Graphics
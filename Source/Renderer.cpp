@@ -1,12 +1,18 @@
 #include "Renderer.hpp"
 #include "Graphics.hpp"
 #include "Hash.hpp"
+#include "ImageDecode.hpp"
 #include "Log.hpp"
 
 #include <glad/gl.h>
 
 #include <GLFW/glfw3.h>
 
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstring>
+
 namespace Graphics {
 
 void debugMessageOutput(
@@ -20,10 +26,30 @@ struct DrawElementsIndirectCommand {
     uint32_t baseInstance;
 };
 
+// Counters the culling pass accumulates over both phases of a frame.
+struct CullingStats {
+    uint32_t frustumCulledInstances;
+    uint32_t occludedInstances;
+    uint32_t disoccludedInstances;
+    uint32_t renderedTriangles;
+    std::array<uint32_t, MaxMeshLODs> lodInstances;
+    uint32_t visibleInstances;
+    uint32_t visibleMeshlets;
+};
+
+// What one frame copies into the culling readback ring: its counters and the commands each range submitted.
+struct CullingReadback {
+    CullingStats stats;
+    std::array<uint32_t, 2> drawCounts;
+};
+
 constexpr std::array<std::string_view, 2> MeshShaderNames = { RESOURCE_PATH "/Shaders/Mesh.vert", RESOURCE_PATH "/Shaders/Mesh.frag" };
 constexpr std::array<std::string_view, 2> PostProcessingShaderNames
     = { RESOURCE_PATH "/Shaders/PostProcessing.vert", RESOURCE_PATH "/Shaders/PostProcessing.frag" };
 constexpr std::string_view CullingShaderName = RESOURCE_PATH "/Shaders/Culling.comp";
+constexpr std::string_view DepthShaderName = RESOURCE_PATH "/Shaders/Depth.vert";
+constexpr std::string_view DepthPyramidShaderName = RESOURCE_PATH "/Shaders/DepthPyramid.comp";
+constexpr std::string_view InstanceBucketsShaderName = RESOURCE_PATH "/Shaders/InstanceBuckets.comp";
 constexpr std::array<std::string_view, 2> EnvironmentShaderNames
     = { RESOURCE_PATH "/Shaders/Environment.vert", RESOURCE_PATH "/Shaders/Environment.frag" };
 constexpr std::array<std::string_view, 2> EquirectangularToCubemapShaderNames { RESOURCE_PATH "/Shaders/Cubemap.vert",
@@ -45,8 +71,11 @@ constexpr uint64_t EquirectangularToCubemapPipelineTag = 5;
 constexpr uint64_t IrradianceConvolutionPipelineTag = 6;
 constexpr uint64_t PrefilterPipelineTag = 7;
 constexpr uint64_t BRDFPipelineTag = 8;
+constexpr uint64_t DepthPipelineTag = 9;
+constexpr uint64_t DepthPyramidPipelineTag = 10;
+constexpr uint64_t InstanceBucketsPipelineTag = 11;
 
-constexpr uint64_t VertexBufferTag = 1;
+constexpr uint64_t PositionBufferTag = 1;
 constexpr uint64_t IndexBufferTag = 2;
 constexpr uint64_t InstanceBufferTag = 3;
 constexpr uint64_t IndirectBufferTag = 4;
@@ -56,16 +85,51 @@ constexpr uint64_t DrawableBufferTag = 7;
 constexpr uint64_t MeshPropertyBufferTag = 8;
 constexpr uint64_t LightBufferTag = 9;
 constexpr uint64_t LightIndicesBufferTag = 10;
+constexpr uint64_t VertexAttributeBufferTag = 11;
+constexpr uint64_t MeshletBufferTag = 12;
+constexpr uint64_t OcclusionBufferTag = 13;
+constexpr uint64_t CullingStatsBufferTag = 14;
+constexpr uint64_t DrawCountBufferTag = 15;
+constexpr uint64_t InstanceRemapBufferTag = 16;
+constexpr uint64_t InstanceSlotBufferTag = 17;
+constexpr uint64_t InstanceBucketBufferTag = 18;
+constexpr uint64_t SceneStagingBufferTag = 19;
+
+// minimum GL_MAX_COMPUTE_WORK_GROUP_COUNT per dimension
+constexpr size_t MaxWorkgroupCount = 65535;
 
-constexpr uint64_t SceneDepthBufferTag = 1;
 constexpr uint64_t SceneColorTextureTag = 1;
 constexpr uint64_t EnvironmentCubemapTag = 2;
 constexpr uint64_t IrradianceCubemapTag = 3;
 constexpr uint64_t PrefilterCubemapTag = 4;
 constexpr uint64_t brdfLUTTextureTag = 5;
+constexpr uint64_t SceneDepthTextureTag = 6;
+constexpr uint64_t DepthPyramidTextureTag = 7;
 
 constexpr uint64_t PostProcessingFramebufferTag = 1;
 
+// Points binding 0 of both vertex arrays at the position stream and binding 1 of the mesh vertex array at the attribute stream.
+static auto bindVertexStreams(Device& device, uint32_t positionBuffer, uint32_t attributeBuffer) -> void {
+    const GLsizei positionStride = device.quantizeVertices ? sizeof(PackedPosition) : sizeof(vec3);
+    const GLsizei attributeStride = device.quantizeVertices ? sizeof(PackedAttributes) : sizeof(VertexAttributes);
+
+    glVertexArrayVertexBuffer(device.meshVertexArray, 0, positionBuffer, 0, positionStride);
+    glVertexArrayVertexBuffer(device.meshVertexArray, 1, attributeBuffer, 0, attributeStride);
+    glVertexArrayVertexBuffer(device.positionVertexArray, 0, positionBuffer, 0, positionStride);
+}
+
+// Position is attribute 0 in every mesh vertex array.
+static auto setupPositionAttribute(Device& device, uint32_t vertexArray) -> void {
+    if (device.quantizeVertices) {
+        glVertexArrayAttribFormat(vertexArray, 0, 4, GL_UNSIGNED_SHORT, GL_TRUE, 0);
+    } else {
+        glVertexArrayAttribFormat(vertexArray, 0, 3, GL_FLOAT, GL_FALSE, 0);
+    }
+
+    glVertexArrayAttribBinding(vertexArray, 0, 0);
+    glEnableVertexArrayAttrib(vertexArray, 0);
+}
+
 static auto buildEnvironmentCubemap(Device& device) {
     const auto clearColor = std::array { 0.1f, 0.1f, 0.1f, 1.f };
     const auto clearDepth = 1.f;
@@ -305,47 +369,157 @@ static auto buildEnvironmentCubemap(Device& device) {
     }
 }
 
+// Grows a GPU-written buffer to at least `size` bytes; its previous contents are not preserved.
+static auto reserveBuffer(Device& device, uint64_t tag, size_t size) -> Buffer {
+    const auto ref = device.bufferIndex_.find(tag);
+    assert(ref != TagIndex::InvalidRef);
+
+    auto& buffer = device.buffers_[ref];
+    if (buffer.size < size) {
+        buffer.size = std::max<size_t>(size, buffer.size * 2);
+        glNamedBufferData(buffer.id, buffer.size, nullptr, GL_DYNAMIC_DRAW);
+    }
+
+    return buffer;
+}
+
+// Grows a buffer to at least `size` bytes by doubling its capacity.
+// The old contents are copied into the new storage on the GPU, so only changed ranges have to be uploaded afterwards.
+static auto growBuffer(Device& device, uint64_t tag, size_t size) -> Buffer {
+    const auto ref = device.bufferIndex_.find(tag);
+    assert(ref != TagIndex::InvalidRef);
+
+    auto& buffer = device.buffers_[ref];
+    if (buffer.size >= size) {
+        return buffer;
+    }
+
+    const size_t capacity = std::max<size_t>(size, buffer.size * 2);
+
+    auto id = 0u;
+    glCreateBuffers(1, &id);
+    glNamedBufferStorage(id, capacity, nullptr, GL_DYNAMIC_STORAGE_BIT);
+
+    if (buffer.size != 0) {
+        glCopyNamedBufferSubData(buffer.id, id, 0, 0, buffer.size);
+    }
+
+    glDeleteBuffers(1, &buffer.id);
+
+    buffer.id = id;
+    buffer.size = capacity;
+
+    return buffer;
+}
+
+template <typename T>
+static auto uploadRanges(Device& device, uint64_t tag, const std::vector<T>& values, std::span<const DirtyRanges::Range> ranges) -> Buffer {
+    auto buffer = growBuffer(device, tag, std::size(values) * sizeof(T));
+
+    for (const auto& range : ranges) {
+        const size_t end = std::min(range.end, std::size(values));
+        if (range.begin >= end) {
+            continue;
+        }
+
+        glNamedBufferSubData(buffer.id, range.begin * sizeof(T), (end - range.begin) * sizeof(T), std::data(values) + range.begin);
+    }
+
+    return buffer;
+}
+
+template <typename T>
+static auto uploadDirtyRanges(Device& device, uint64_t tag, const std::vector<T>& values, DirtyRanges& dirty) -> Buffer {
+    auto buffer = uploadRanges(device, tag, values, dirty.coalesce());
+
+    dirty.clear();
+
+    return buffer;
+}
+
 auto initialize(Device& device, const DeviceConfiguration& conf) -> bool {
     assert(conf.window);
 
+    device.jobSystem_ = std::make_unique<JobSystem>(conf.numJobThreads);
+    device.textureStreamer_ = createTextureStreamer({ .stagingSize = conf.textureStagingSize, .frameBudget = conf.textureUploadBudget });
+
     if (conf.numTextures) {
         device.textures_.reserve(conf.numTextures);
         device.textureHandles_.reserve(conf.numTextures);
+        device.textureSlots_.reserve(conf.numTextures);
+        device.textureContentIndex_.reserve(conf.numTextures);
+        device.textureHandleSlots_.reserve(conf.numTextures);
+        device.textureIndex_.reserve(conf.numTextures);
+        device.textureHandleIndex_.reserve(conf.numTextures);
     }
     if (conf.numShaders) {
         device.shaders_.reserve(conf.numShaders);
+        device.shaderIndex_.reserve(conf.numShaders);
     }
     if (conf.numPipelines) {
         device.pipelines_.reserve(conf.numPipelines);
+        device.pipelineIndex_.reserve(conf.numPipelines);
     }
     if (conf.numBuffers) {
         device.buffers_.reserve(conf.numBuffers);
+        device.bufferIndex_.reserve(conf.numBuffers);
     }
     if (conf.numBuffers) {
         device.framebuffers_.reserve(conf.numFramebuffers);
     }
 
+    device.quantizeVertices = conf.quantizeVertices;
+    device.bakeTexturesOnLoad = conf.bakeTexturesOnLoad;
+
+    // glMultiDrawElementsIndirectCount is core since 4.6, older contexts draw fixed per-drawable command ranges
+    device.supportsDrawIndirectCount = GLAD_GL_VERSION_4_6 != 0;
+
     if (conf.numVertices) {
-        device.vertices_.reserve(conf.numVertices);
+        device.vertexAllocator_.grow(conf.numVertices);
+        if (device.quantizeVertices) {
+            device.packedPositions_.resize(conf.numVertices);
+            device.packedAttributes_.resize(conf.numVertices);
+        } else {
+            device.positions_.resize(conf.numVertices);
+            device.vertexAttributes_.resize(conf.numVertices);
+        }
+    }
+    if (conf.numMeshlets) {
+        device.meshletAllocator_.grow(conf.numMeshlets);
+        device.meshlets_.resize(conf.numMeshlets);
     }
     if (conf.numIndices) {
-        device.indices_.reserve(conf.numIndices);
+        device.indexAllocator_.grow(conf.numIndices);
+        device.indices_.resize(conf.numIndices);
     }
     if (conf.numMaterials) {
         device.materials_.reserve(conf.numMaterials);
+        device.materialSlots_.reserve(conf.numMaterials);
     }
     if (conf.numMeshes) {
         device.meshProperties_.reserve(conf.numMeshes);
+        device.meshSlots_.reserve(conf.numMeshes);
+        device.meshIndex_.reserve(conf.numMeshes);
+        device.meshAllocations_.reserve(conf.numMeshes);
     }
     if (conf.numLights) {
         device.lights_.reserve(conf.numLights);
     }
     if (conf.numModels) {
         device.models_.reserve(conf.numModels);
+        device.modelSlots_.reserve(conf.numModels);
+        device.modelIndex_.reserve(conf.numModels);
     }
     if (conf.numEntities) {
-        device.modelMatrices_.reserve(conf.numEntities);
-        device.drawables_.reserve(conf.numEntities);
+        device.entities_.reserve(conf.numEntities);
+        device.entitySlots_.reserve(conf.numEntities);
+        device.entityTransforms_.resize(conf.numEntities);
+
+        // at least one drawable per entity, the slots start out empty
+        device.drawableAllocator_.grow(conf.numEntities);
+        device.instanceTransforms_.resize(conf.numEntities);
+        device.drawables_.resize(conf.numEntities);
+        device.dirtyDrawables_.add(0, conf.numEntities);
     }
 
     int32_t framebufferWidth = 0, framebufferHeight = 0;
@@ -361,21 +535,59 @@ auto initialize(Device& device, const DeviceConfiguration& conf) -> bool {
         glDebugMessageCallback(debugMessageOutput, &device.debugOutputParams_);
     }
 
+    // the 4k environment map takes longest to decode, so it decodes on the job system while the rest is set up
+    DecodedImage environmentImage;
+    JobCounter environmentDecode { 0 };
+    device.jobSystem_->schedule(
+        environmentDecode, [&environmentImage] { environmentImage = decodeImageFile(EnvironmentTextureName, 0, true); });
+
     loadShader(device, MeshShaderNames[0]);
     loadShader(device, MeshShaderNames[1]);
     loadShader(device, CullingShaderName);
-    loadTexture(device, EnvironmentTextureName);
+    loadShader(device, DepthShaderName);
+    loadShader(device, DepthPyramidShaderName);
+    loadShader(device, InstanceBucketsShaderName);
 
-    auto vertexBuffer = createBuffer(device, { .tag = VertexBufferTag });
-    auto indexBuffer = createBuffer(device, { .tag = IndexBufferTag });
-    auto instanceBuffer = createBuffer(device, { .tag = InstanceBufferTag });
+    createBuffer(device, { .tag = PositionBufferTag });
+    createBuffer(device, { .tag = VertexAttributeBufferTag });
+    createBuffer(device, { .tag = IndexBufferTag });
     createBuffer(device, { .tag = IndirectBufferTag });
     createBuffer(device, { .tag = MaterialBufferTag });
     createBuffer(device, { .tag = LightBufferTag });
     createBuffer(device, { .tag = LightIndicesBufferTag });
     createBuffer(device, { .tag = TextureHandleBufferTag });
-    createBuffer(device, { .tag = DrawableBufferTag });
     createBuffer(device, { .tag = MeshPropertyBufferTag });
+    createBuffer(device, { .tag = MeshletBufferTag });
+    createBuffer(device, { .tag = OcclusionBufferTag });
+    createBuffer(device, { .tag = CullingStatsBufferTag });
+    createBuffer(device, { .tag = DrawCountBufferTag });
+    createBuffer(device, { .tag = InstanceRemapBufferTag });
+    createBuffer(device, { .tag = InstanceSlotBufferTag });
+    createBuffer(device, { .tag = InstanceBucketBufferTag });
+    createBuffer(device, { .tag = InstanceBufferTag });
+    createBuffer(device, { .tag = DrawableBufferTag });
+
+    // pre-grow the global buffers so loading content only uploads the appended ranges
+    const size_t numVertices = std::max<size_t>(conf.numVertices, 1);
+    const size_t positionSize = device.quantizeVertices ? sizeof(PackedPosition) : sizeof(vec3);
+    const size_t attributeSize = device.quantizeVertices ? sizeof(PackedAttributes) : sizeof(VertexAttributes);
+    auto positionBuffer = growBuffer(device, PositionBufferTag, numVertices * positionSize);
+    auto attributeBuffer = growBuffer(device, VertexAttributeBufferTag, numVertices * attributeSize);
+    auto indexBuffer = growBuffer(device, IndexBufferTag, std::max<size_t>(conf.numIndices, 1) * sizeof(uint32_t));
+    growBuffer(device, MeshPropertyBufferTag, std::max<size_t>(conf.numMeshes, 1) * sizeof(MeshProperty));
+    growBuffer(device, MeshletBufferTag, std::max<size_t>(conf.numMeshlets, 1) * sizeof(Meshlet));
+    growBuffer(device, MaterialBufferTag, std::max<size_t>(conf.numMaterials, 1) * sizeof(Material));
+    growBuffer(device, TextureHandleBufferTag, std::max<size_t>(conf.numTextures, 1) * sizeof(uint64_t));
+    growBuffer(device, LightBufferTag, std::max<size_t>(conf.numLights, 1) * sizeof(Light));
+    reserveBuffer(device, CullingStatsBufferTag, sizeof(CullingStats));
+    reserveBuffer(device, DrawCountBufferTag, 2 * sizeof(uint32_t));
+
+    growBuffer(device, InstanceBufferTag, std::max<size_t>(conf.numEntities, 1) * sizeof(mat4));
+    growBuffer(device, DrawableBufferTag, std::max<size_t>(conf.numEntities, 1) * sizeof(Drawable));
+    device.cullingReadback_ = createReadbackRing(sizeof(CullingReadback));
+    // a region fits a frame in which every entity moved
+    device.sceneStagingRing_ = createRingBuffer(
+        { .tag = SceneStagingBufferTag, .frameSize = std::max<size_t>(conf.numEntities, 1) * (sizeof(mat4) + sizeof(Drawable)) });
 
     auto sceneColorTexture = createTexture2D(device,
         { .tag = SceneColorTextureTag,
@@ -387,11 +599,29 @@ auto initialize(Device& device, const DeviceConfiguration& conf) -> bool {
             .filter = Graphics::TextureFiltering::Bilinear,
             .wrap = Graphics::TextureWrap::ClampToEdge });
 
-    auto sceneDepthBuffer = createRenderbuffer(device,
-        { .tag = SceneDepthBufferTag,
+    // a texture rather than a renderbuffer, the depth pyramid is built from it
+    auto sceneDepthTexture = createTexture2D(device,
+        { .tag = SceneDepthTextureTag,
             .width = static_cast<uint32_t>(framebufferWidth),
             .height = static_cast<uint32_t>(framebufferHeight),
-            .format = Graphics::Format::D24_UNORM });
+            .format = Graphics::Format::D24_UNORM,
+            .mipLevels = 1,
+            .generateMipMaps = false,
+            .filter = Graphics::TextureFiltering::Nearest,
+            .wrap = Graphics::TextureWrap::ClampToEdge });
+
+    // the largest power of two that fits the scene, so every level halves the one above
+    const auto pyramidWidth = std::bit_floor(static_cast<uint32_t>(framebufferWidth));
+    const auto pyramidHeight = std::bit_floor(static_cast<uint32_t>(framebufferHeight));
+    createTexture2D(device,
+        { .tag = DepthPyramidTextureTag,
+            .width = pyramidWidth,
+            .height = pyramidHeight,
+            .format = Graphics::Format::R32_FLOAT,
+            .mipLevels = static_cast<uint32_t>(std::bit_width(std::max(pyramidWidth, pyramidHeight))),
+            .generateMipMaps = false,
+            .filter = Graphics::TextureFiltering::Nearest,
+            .wrap = Graphics::TextureWrap::ClampToEdge });
 
     auto postProcessingFramebuffer = createFramebuffer(device,
         { .tag = PostProcessingFramebufferTag,
@@ -402,7 +632,7 @@ auto initialize(Device& device, const DeviceConfiguration& conf) -> bool {
                                             .attachmentTarget = GL_TEXTURE_2D,
                                             .renderTarget = sceneColorTexture.id },
                 Graphics::FramebufferAttachment {
-                    .attachment = GL_DEPTH_ATTACHMENT, .attachmentTarget = GL_RENDERBUFFER, .renderTarget = sceneDepthBuffer.id } },
+                    .attachment = GL_DEPTH_ATTACHMENT, .attachmentTarget = GL_TEXTURE_2D, .renderTarget = sceneDepthTexture.id } },
             .drawBuffers = std::array<GLenum, 1> { GL_COLOR_ATTACHMENT0 } });
 
     assert(postProcessingFramebuffer.is_complete());
@@ -447,77 +677,118 @@ auto initialize(Device& device, const DeviceConfiguration& conf) -> bool {
             .wrap = TextureWrap::ClampToEdge });
 
     glCreateVertexArrays(1, &device.meshVertexArray);
+    glCreateVertexArrays(1, &device.positionVertexArray);
     glVertexArrayElementBuffer(device.meshVertexArray, indexBuffer.id);
+    glVertexArrayElementBuffer(device.positionVertexArray, indexBuffer.id);
 
-    // per-vertex attributes
-    glVertexArrayAttribFormat(device.meshVertexArray, 0, 3, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribFormat(device.meshVertexArray, 1, 3, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribFormat(device.meshVertexArray, 2, 2, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribFormat(device.meshVertexArray, 3, 3, GL_FLOAT, GL_FALSE, 0);
+    // per-vertex attributes: positions from binding 0, the rest interleaved in binding 1
+    setupPositionAttribute(device, device.meshVertexArray);
+    setupPositionAttribute(device, device.positionVertexArray);
 
-    glVertexArrayVertexBuffer(device.meshVertexArray, 0, vertexBuffer.id, offsetof(Vertex, position), sizeof(Vertex));
-    glVertexArrayVertexBuffer(device.meshVertexArray, 1, vertexBuffer.id, offsetof(Vertex, normal), sizeof(Vertex));
-    glVertexArrayVertexBuffer(device.meshVertexArray, 2, vertexBuffer.id, offsetof(Vertex, uv), sizeof(Vertex));
-    glVertexArrayVertexBuffer(device.meshVertexArray, 3, vertexBuffer.id, offsetof(Vertex, tangent), sizeof(Vertex));
+    if (device.quantizeVertices) {
+        glVertexArrayAttribFormat(device.meshVertexArray, 1, 2, GL_SHORT, GL_TRUE, offsetof(PackedAttributes, normal));
+        glVertexArrayAttribFormat(device.meshVertexArray, 2, 2, GL_HALF_FLOAT, GL_FALSE, offsetof(PackedAttributes, uv));
+        glVertexArrayAttribFormat(device.meshVertexArray, 3, 2, GL_SHORT, GL_TRUE, offsetof(PackedAttributes, tangent));
+    } else {
+        glVertexArrayAttribFormat(device.meshVertexArray, 1, 3, GL_FLOAT, GL_FALSE, offsetof(VertexAttributes, normal));
+        glVertexArrayAttribFormat(device.meshVertexArray, 2, 2, GL_FLOAT, GL_FALSE, offsetof(VertexAttributes, uv));
+        glVertexArrayAttribFormat(device.meshVertexArray, 3, 3, GL_FLOAT, GL_FALSE, offsetof(VertexAttributes, tangent));
+    }
+
+    glVertexArrayAttribBinding(device.meshVertexArray, 1, 1);
+    glVertexArrayAttribBinding(device.meshVertexArray, 2, 1);
+    glVertexArrayAttribBinding(device.meshVertexArray, 3, 1);
 
-    glEnableVertexArrayAttrib(device.meshVertexArray, 0);
     glEnableVertexArrayAttrib(device.meshVertexArray, 1);
     glEnableVertexArrayAttrib(device.meshVertexArray, 2);
     glEnableVertexArrayAttrib(device.meshVertexArray, 3);
 
-    // per-instance attributes
-    glVertexArrayAttribFormat(device.meshVertexArray, 4, 4, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribFormat(device.meshVertexArray, 5, 4, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribFormat(device.meshVertexArray, 6, 4, GL_FLOAT, GL_FALSE, 0);
-    glVertexArrayAttribFormat(device.meshVertexArray, 7, 4, GL_FLOAT, GL_FALSE, 0);
+    bindVertexStreams(device, positionBuffer.id, attributeBuffer.id);
 
-    glVertexArrayVertexBuffer(device.meshVertexArray, 4, instanceBuffer.id, sizeof(vec4) * 0, sizeof(mat4));
-    glVertexArrayVertexBuffer(device.meshVertexArray, 5, instanceBuffer.id, sizeof(vec4) * 1, sizeof(mat4));
-    glVertexArrayVertexBuffer(device.meshVertexArray, 6, instanceBuffer.id, sizeof(vec4) * 2, sizeof(mat4));
-    glVertexArrayVertexBuffer(device.meshVertexArray, 7, instanceBuffer.id, sizeof(vec4) * 3, sizeof(mat4));
+    glCreateVertexArrays(1, &device.fullscreenQuadVertexArray);
 
-    glEnableVertexArrayAttrib(device.meshVertexArray, 4);
-    glEnableVertexArrayAttrib(device.meshVertexArray, 5);
-    glEnableVertexArrayAttrib(device.meshVertexArray, 6);
-    glEnableVertexArrayAttrib(device.meshVertexArray, 7);
+    device.jobSystem_->wait(environmentDecode);
+    if (!environmentImage) {
+        LOG_ERROR("Can't load {}", EnvironmentTextureName);
+        return false;
+    }
 
-    glVertexArrayBindingDivisor(device.meshVertexArray, 4, 1);
-    glVertexArrayBindingDivisor(device.meshVertexArray, 5, 1);
-    glVertexArrayBindingDivisor(device.meshVertexArray, 6, 1);
-    glVertexArrayBindingDivisor(device.meshVertexArray, 7, 1);
+    LOG_INFO("Decoded {} {}x{} in {:.2f} ms", EnvironmentTextureName, environmentImage.width, environmentImage.height,
+        environmentImage.decodeMilliseconds);
 
-    glCreateVertexArrays(1, &device.fullscreenQuadVertexArray);
+    createTexture2D(device, environmentImage, { .tag = make_hash(EnvironmentTextureName), .mipLevels = 4, .generateMipMaps = true });
 
     return true;
 }
 
 auto cleanup(Device& device) -> void {
+    destroyTextureStreamer(device.textureStreamer_, *device.jobSystem_);
+    device.jobSystem_.reset();
+
+    destroyReadbackRing(device.cullingReadback_);
+    destroyRingBuffer(device.sceneStagingRing_);
+
     for (const auto t : device.textureHandles_) {
         if (t != 0) {
             glMakeTextureHandleNonResidentARB(t);
         }
     }
     device.textureHandles_.clear();
+    device.textureHandleIndex_.clear();
+    device.textureHandleSlots_.clear();
+    device.textureRefCounts_.clear();
+    device.textureContentKeys_.clear();
+    device.textureContentIndex_.clear();
+    device.residentTextures = 0;
+    device.residentTextureBytes = 0;
 
     for (auto& t : device.textures_) {
         glDeleteTextures(1, &t.id);
     }
     device.textures_.clear();
+    device.textureIndex_.clear();
+    device.textureSlots_.clear();
 
     for (auto& s : device.shaders_) {
         glDeleteProgram(s.id);
     }
     device.shaders_.clear();
+    device.shaderIndex_.clear();
 
     for (auto& p : device.pipelines_) {
         glDeleteProgramPipelines(1, &p.id);
     }
     device.pipelines_.clear();
+    device.pipelineIndex_.clear();
 
     for (auto& b : device.buffers_) {
         glDeleteBuffers(1, &b.id);
     }
     device.buffers_.clear();
+    device.bufferIndex_.clear();
+
+    device.positions_.clear();
+    device.vertexAttributes_.clear();
+    device.packedPositions_.clear();
+    device.packedAttributes_.clear();
+    device.indices_.clear();
+    device.meshlets_.clear();
+    device.vertexAllocator_ = {};
+    device.indexAllocator_ = {};
+    device.meshletAllocator_ = {};
+    device.meshAllocations_.clear();
+    device.meshHashes_.clear();
+    device.meshRefCounts_.clear();
+    device.meshIndex_.clear();
+
+    device.entities_.clear();
+    device.entitySlots_.clear();
+    device.entityTransforms_ = {};
+    device.entityMatrices_.clear();
+    device.instanceTransforms_.clear();
+    device.drawables_.clear();
+    device.drawableAllocator_ = {};
+    device.commandAllocator_ = {};
 
     for (auto& rb : device.renderbuffers_) {
         glDeleteRenderbuffers(1, &rb.id);
@@ -535,173 +806,507 @@ auto cleanup(Device& device) -> void {
 }
 
 static auto updateMaterialBuffers(Device& device) {
-    if (!device.reloadMaterialBuffers_) {
-        return;
+    if (!device.dirtyMaterials_.empty()) {
+        uploadDirtyRanges(device, MaterialBufferTag, device.materials_, device.dirtyMaterials_);
+    }
+
+    if (!device.dirtyTextureHandles_.empty()) {
+        uploadDirtyRanges(device, TextureHandleBufferTag, device.textureHandles_, device.dirtyTextureHandles_);
     }
+}
 
-    device.reloadMaterialBuffers_ = false;
+static auto updateMeshBuffers(Device& device) {
+    if (!device.dirtyVertices_.empty() || !device.dirtyIndices_.empty()) {
+        // both vertex streams share the dirty ranges
+        const auto ranges = device.dirtyVertices_.coalesce();
+        auto positionBuffer = device.quantizeVertices ? uploadRanges(device, PositionBufferTag, device.packedPositions_, ranges)
+                                                      : uploadRanges(device, PositionBufferTag, device.positions_, ranges);
+        auto attributeBuffer = device.quantizeVertices ? uploadRanges(device, VertexAttributeBufferTag, device.packedAttributes_, ranges)
+                                                       : uploadRanges(device, VertexAttributeBufferTag, device.vertexAttributes_, ranges);
+        device.dirtyVertices_.clear();
+
+        auto indexBuffer = uploadDirtyRanges(device, IndexBufferTag, device.indices_, device.dirtyIndices_);
+
+        // growing replaces the buffer objects
+        glVertexArrayElementBuffer(device.meshVertexArray, indexBuffer.id);
+        glVertexArrayElementBuffer(device.positionVertexArray, indexBuffer.id);
+        bindVertexStreams(device, positionBuffer.id, attributeBuffer.id);
+    }
 
-    auto materialBuffer = findBuffer(device, MaterialBufferTag);
-    auto textureHandleBuffer = findBuffer(device, TextureHandleBufferTag);
+    if (!device.dirtyMeshlets_.empty()) {
+        uploadDirtyRanges(device, MeshletBufferTag, device.meshlets_, device.dirtyMeshlets_);
+    }
 
-    glNamedBufferData(materialBuffer.id, std::size(device.materials_) * sizeof(Material), std::data(device.materials_), GL_DYNAMIC_DRAW);
+    if (!device.dirtyMeshProperties_.empty()) {
+        uploadDirtyRanges(device, MeshPropertyBufferTag, device.meshProperties_, device.dirtyMeshProperties_);
+    }
+}
 
-    if (!device.textureHandles_.empty()) {
-        glNamedBufferData(textureHandleBuffer.id, std::size(device.textureHandles_) * sizeof(uint64_t), std::data(device.textureHandles_),
-            GL_DYNAMIC_DRAW);
+// Command slots a drawable of `mesh` needs, so that the culling pass can emit every meshlet of any LOD.
+static auto meshCommandCount(const MeshProperty& mesh) -> uint32_t {
+    uint32_t count = 1;
+    for (const auto& lod : mesh.LODs) {
+        count = std::max(count, lod.meshletCount);
     }
+
+    return count;
 }
 
-static auto updateMeshBuffers(Device& device) {
-    if (!device.reloadMeshBuffers_) {
-        return;
+static auto updateLightBuffer(Device& device) {
+    if (!device.dirtyLights_.empty()) {
+        uploadDirtyRanges(device, LightBufferTag, device.lights_, device.dirtyLights_);
     }
+}
 
-    device.reloadMeshBuffers_ = false;
+// Allocates drawable slots, marking the ones added by growing dirty so the GPU copy of the empty slots gets initialized too.
+static auto allocateDrawables(Device& device, uint32_t count) -> RangeAllocation {
+    const auto capacity = device.drawableAllocator_.capacity();
+    const auto allocation = allocateRange(device.drawableAllocator_, count, device.instanceTransforms_, device.drawables_);
 
-    auto vertexBuffer = findBuffer(device, VertexBufferTag);
-    auto indexBuffer = findBuffer(device, IndexBufferTag);
-    auto meshPropertyBuffer = findBuffer(device, MeshPropertyBufferTag);
+    if (device.drawableAllocator_.capacity() > capacity) {
+        device.dirtyDrawables_.add(capacity, device.drawableAllocator_.capacity() - capacity);
+    }
 
-    glNamedBufferData(vertexBuffer.id, std::size(device.vertices_) * sizeof(Vertex), std::data(device.vertices_), GL_DYNAMIC_DRAW);
-    glNamedBufferData(indexBuffer.id, std::size(device.indices_) * sizeof(uint32_t), std::data(device.indices_), GL_DYNAMIC_DRAW);
-    glNamedBufferData(meshPropertyBuffer.id, std::size(device.meshProperties_) * sizeof(MeshProperty), std::data(device.meshProperties_),
-        GL_DYNAMIC_DRAW);
+    return allocation;
 }
 
-static auto updateLightBuffer(Device& device) {
-    if (!device.reloadLightBuffers_) {
-        return;
+auto createEntity(Device& device, const Entity& entity) -> EntityRef {
+    if (!device.modelSlots_.contains(entity.modelRef)) {
+        return {};
     }
 
-    device.reloadLightBuffers_ = false;
+    const auto& model = device.models_[entity.modelRef.index];
+    const auto meshCount = static_cast<uint32_t>(std::size(model.meshes));
+
+    uint32_t commandCount = 0;
+    for (const auto& mesh : model.meshes) {
+        commandCount += meshCommandCount(device.meshProperties_[mesh.meshRef.index]);
+    }
 
-    auto lightBuffer = findBuffer(device, LightBufferTag);
+    const SceneEntity sceneEntity { .modelRef = entity.modelRef,
+        .drawables = allocateDrawables(device, meshCount),
+        .commands = allocateRange(device.commandAllocator_, commandCount) };
+
+    // the transforms are filled in once the world matrix of the entity is composed
+    uint32_t drawableIndex = sceneEntity.drawables.offset;
+    uint32_t firstCommand = sceneEntity.commands.offset;
+    for (const auto& mesh : model.meshes) {
+        const auto meshCommands = meshCommandCount(device.meshProperties_[mesh.meshRef.index]);
+
+        device.drawables_[drawableIndex] = {
+            .materialRef = mesh.materialRef.index, .meshRef = mesh.meshRef.index, .firstCommand = firstCommand, .commandCount = meshCommands
+        };
+        drawableIndex++;
+        firstCommand += meshCommands;
+    }
 
-    glNamedBufferData(lightBuffer.id, std::size(device.lights_) * sizeof(Light), std::data(device.lights_), GL_DYNAMIC_DRAW);
+    if (meshCount != 0) {
+        device.dirtyDrawables_.add(sceneEntity.drawables.offset, meshCount);
+    }
+
+    const auto ref = device.entitySlots_.allocate();
+    assignSlot(device.entities_, ref.index, sceneEntity);
+
+    if (ref.index >= device.entityTransforms_.size()) {
+        device.entityTransforms_.resize(std::max<size_t>(ref.index + 1, device.entityTransforms_.size() * 2));
+    }
+    device.entityTransforms_.set(ref.index, entity.transform);
+    device.dirtyEntityTransforms_.add(ref.index);
+
+    return ref;
 }
 
-auto present(Device& device, Camera& camera, std::span<const Entity> entities) -> void {
-    assert(!device.framebuffers_.empty());
+auto updateEntity(Device& device, EntityRef ref, const Transform& transform) -> bool {
+    if (!device.entitySlots_.contains(ref)) {
+        return false;
+    }
 
-    if (!device.buildedEnvCubemap || !device.buildedIrradianceCubemap || !device.buildPrefilterCubemap || !device.buildBRDFLUTTexture) {
-        buildEnvironmentCubemap(device);
+    device.entityTransforms_.set(ref.index, transform);
+    device.dirtyEntityTransforms_.add(ref.index);
+
+    return true;
+}
+
+auto destroyEntity(Device& device, EntityRef ref) -> bool {
+    if (!device.entitySlots_.release(ref)) {
+        return false;
     }
 
-    const float aspectRation = static_cast<float>(device.framebuffers_[0].width) / static_cast<float>(device.framebuffers_[0].height);
+    auto& sceneEntity = device.entities_[ref.index];
 
-    mat4 projection = camera.projection(aspectRation);
-    mat4 view = camera.view();
+    // the emptied slots are reused by later entities, the others keep theirs
+    if (const auto& drawables = sceneEntity.drawables; drawables) {
+        std::fill_n(std::begin(device.drawables_) + drawables.offset, drawables.size, Drawable {});
+        device.dirtyDrawables_.add(drawables.offset, drawables.size);
+        device.drawableAllocator_.free(drawables);
+    }
 
-    updateMaterialBuffers(device);
-    updateMeshBuffers(device);
-    updateLightBuffer(device);
+    if (sceneEntity.commands) {
+        device.commandAllocator_.free(sceneEntity.commands);
+    }
 
-    device.modelMatrices_.clear();
-    device.drawables_.clear();
+    sceneEntity = {};
+    device.entityTransforms_.set(ref.index, {});
 
-    for (size_t i = 0; i < std::size(entities); i++) {
-        const auto& model = device.models_[entities[i].modelRef];
-        for (size_t j = 0; j < std::size(model.meshes); j++) {
-            device.modelMatrices_.push_back(entities[i].transform);
-            device.drawables_.emplace_back(model.meshes[j].meshRef, model.meshes[j].materialRef);
+    return true;
+}
+
+// Propagates the node transforms of every model whose nodes moved and marks the entities of those models for an update.
+static auto updateModelTransforms(Device& device) {
+    std::vector<uint32_t> movedModels;
+    for (auto& model : device.models_) {
+        if (device.modelSlots_.contains(model.ref) && propagateTransforms(*device.jobSystem_, model.nodes)) {
+            movedModels.push_back(model.ref.index);
         }
     }
 
-    int32_t instanceCount = static_cast<int32_t>(std::size(device.drawables_));
-    device.drawInstances = instanceCount;
+    if (movedModels.empty()) {
+        return;
+    }
+
+    for (size_t i = 0; i < std::size(device.entities_); i++) {
+        const auto& modelRef = device.entities_[i].modelRef;
+        if (std::ranges::find(movedModels, modelRef.index) != std::end(movedModels)) {
+            device.dirtyEntityTransforms_.add(i);
+        }
+    }
+}
 
-    auto instanceBuffer = findBuffer(device, InstanceBufferTag);
-    auto indirectBuffer = findBuffer(device, IndirectBufferTag);
-    auto drawableBuffer = findBuffer(device, DrawableBufferTag);
+// Composes the world matrices of the entities that moved, a run of consecutive slots at a time, and places every submesh of
+// them at its node.
+static auto updateEntityTransforms(Device& device) {
+    if (device.dirtyEntityTransforms_.empty()) {
+        return;
+    }
 
-    glNamedBufferData(
-        instanceBuffer.id, std::size(device.modelMatrices_) * sizeof(mat4), std::data(device.modelMatrices_), GL_DYNAMIC_DRAW);
-    glNamedBufferData(indirectBuffer.id, instanceCount * sizeof(DrawElementsIndirectCommand), nullptr, GL_DYNAMIC_DRAW);
-    glNamedBufferData(drawableBuffer.id, std::size(device.drawables_) * sizeof(Drawable), std::data(device.drawables_), GL_DYNAMIC_DRAW);
+    device.entityMatrices_.resize(device.entityTransforms_.size());
 
-    //
-    // cull invisible objects
-    //
-    if (auto pipeline = findPipeline(device, CullingPipelineTag); pipeline) {
+    for (const auto& range : device.dirtyEntityTransforms_.coalesce()) {
+        composeWorldMatrices(
+            device.entityTransforms_, range.begin, std::span { device.entityMatrices_ }.subspan(range.begin, range.end - range.begin));
 
-        int workgroupCount = instanceCount / 1024;
-        if (instanceCount % 1024) {
-            workgroupCount++;
+        for (size_t i = range.begin; i < range.end; i++) {
+            const auto& sceneEntity = device.entities_[i];
+            const auto& drawables = sceneEntity.drawables;
+            if (!drawables || !device.modelSlots_.contains(sceneEntity.modelRef)) {
+                continue;
+            }
+
+            const auto& model = device.models_[sceneEntity.modelRef.index];
+            for (uint32_t j = 0; j < drawables.size; j++) {
+                const auto& mesh = model.meshes[j];
+                device.instanceTransforms_[drawables.offset + j] = device.entityMatrices_[i] * model.nodes.worlds[mesh.parent] * mesh.local;
+            }
+            device.dirtyInstanceTransforms_.add(drawables.offset, drawables.size);
         }
+    }
 
-        glBindProgramPipeline(pipeline.id);
+    device.dirtyEntityTransforms_.clear();
+}
 
-        auto cs = findShader(device, make_hash(CullingShaderName));
+static auto stagedSize(std::span<const DirtyRanges::Range> ranges, size_t count, size_t elementSize) -> size_t {
+    size_t size = 0;
+    for (const auto& range : ranges) {
+        size += range.begin < count ? (std::min(range.end, count) - range.begin) * elementSize : 0;
+    }
 
-        glProgramUniform1f(cs.id, 0, glm::radians(camera.fieldOfView));
-        glProgramUniform1f(cs.id, 1, aspectRation);
-        glProgramUniform1f(cs.id, 2, camera.nearPlane);
-        glProgramUniform1f(cs.id, 3, camera.farPlane);
-        glProgramUniformMatrix4fv(cs.id, 4, 1, false, &view[0][0]);
-        glProgramUniform1i(cs.id, 5, device.culling ? 0 : 1);
+    return size;
+}
 
-        auto instanceBuffer = findBuffer(device, InstanceBufferTag);
-        auto indirectBuffer = findBuffer(device, IndirectBufferTag);
-        auto drawableBuffer = findBuffer(device, DrawableBufferTag);
-        auto meshPropertyBuffer = findBuffer(device, MeshPropertyBufferTag);
+// Writes the ranges into the mapped staging region at `offset` and copies them from there into the resident buffer on the GPU.
+template <typename T>
+static auto stageRanges(Device& device, uint64_t tag, const std::vector<T>& values, std::span<const DirtyRanges::Range> ranges,
+    std::span<uint8_t> staging, size_t offset) -> size_t {
+    const auto buffer = growBuffer(device, tag, std::size(values) * sizeof(T));
+    const auto& ring = device.sceneStagingRing_;
 
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, instanceBuffer.id);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, indirectBuffer.id);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, drawableBuffer.id);
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, meshPropertyBuffer.id);
+    for (const auto& range : ranges) {
+        const size_t end = std::min(range.end, std::size(values));
+        if (range.begin >= end) {
+            continue;
+        }
 
-        glDispatchCompute(workgroupCount, 1, 1);
+        const size_t size = (end - range.begin) * sizeof(T);
+        std::memcpy(std::data(staging) + offset, std::data(values) + range.begin, size);
+        glCopyNamedBufferSubData(ring.id, buffer.id, ringBufferOffset(ring) + offset, range.begin * sizeof(T), size);
 
-        glBindProgramPipeline(0);
+        offset += size;
+    }
 
-        glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
-    } else {
+    return offset;
+}
+
+// Changed instance transforms and drawables go through the persistently mapped ring, so a scene where everything moves
+// costs a memcpy and a GPU copy instead of a driver-side copy of client memory.
+static auto updateSceneBuffers(Device& device) {
+    if (device.dirtyInstanceTransforms_.empty() && device.dirtyDrawables_.empty()) {
+        return;
+    }
+
+    const auto instanceRanges = device.dirtyInstanceTransforms_.coalesce();
+    const auto drawableRanges = device.dirtyDrawables_.coalesce();
+
+    const size_t instanceSize = stagedSize(instanceRanges, std::size(device.instanceTransforms_), sizeof(mat4));
+    const size_t drawableSize = stagedSize(drawableRanges, std::size(device.drawables_), sizeof(Drawable));
+
+    const auto staging = acquireRingBufferFrame(device.sceneStagingRing_, instanceSize + drawableSize);
+
+    const auto offset = stageRanges(device, InstanceBufferTag, device.instanceTransforms_, instanceRanges, staging, 0);
+    stageRanges(device, DrawableBufferTag, device.drawables_, drawableRanges, staging, offset);
+
+    releaseRingBufferFrame(device.sceneStagingRing_);
+
+    device.dirtyInstanceTransforms_.clear();
+    device.dirtyDrawables_.clear();
+}
+
+// Per-frame state shared by the culling and scene passes.
+struct FrameState {
+    mat4 projection;
+    mat4 view;
+    vec3 viewPosition;
+    float fieldOfView;
+    float aspectRatio;
+    float nearPlane;
+    float farPlane;
+    size_t drawableCount;
+    Buffer instanceBuffer;
+    size_t instanceDataSize;
+    Buffer drawableBuffer;
+    size_t drawableDataSize;
+    uint32_t commandCount;
+    Buffer indirectBuffer;
+    // visible commands are packed and drawn with the count the culling pass wrote
+    bool compactCommands;
+    Buffer drawCountBuffer;
+    // one instanced command per visible mesh LOD, the instances of which are read through the remap buffer
+    bool mergeInstances;
+};
+
+// Matches the phase constants of Culling.comp.
+enum class CullingPhase : int32_t {
+    // frustum and meshlet culling only
+    Frustum,
+    // also rejects instances hidden by the depth pyramid of the previous frame
+    Occlusion,
+    // tests the instances the occlusion phase rejected again, against the depth pyramid of this frame
+    Disocclusion,
+};
+
+// Emits one instanced command per mesh LOD the culling pass bucketed visible instances into, then scatters the drawables into
+// the remap buffer so that instance `i` of a command reads drawable `instanceRemap[baseInstance + i]`.
+static auto mergeInstances(Device& device, const FrameState& frame, CullingPhase phase) -> void {
+    auto pipeline = findPipeline(device, InstanceBucketsPipelineTag);
+    if (!pipeline) {
+        loadPipeline(device, InstanceBucketsPipelineTag, std::array { InstanceBucketsShaderName });
+        return;
+    }
+
+    const bool disocclusion = phase == CullingPhase::Disocclusion;
+
+    auto cs = findShader(device, make_hash(InstanceBucketsShaderName));
+    auto instanceRemapBuffer = findBuffer(device, InstanceRemapBufferTag);
+
+    glBindProgramPipeline(pipeline.id);
+
+    glProgramUniform1ui(cs.id, 1, disocclusion ? frame.commandCount : 0);
+    glProgramUniform1ui(cs.id, 2, disocclusion ? static_cast<uint32_t>(frame.drawableCount) : 0);
+    glProgramUniform1ui(cs.id, 3, disocclusion ? 1 : 0);
+    glProgramUniform1i(cs.id, 4, frame.compactCommands);
+    glProgramUniform1ui(cs.id, 5, static_cast<uint32_t>(frame.drawableCount));
+
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, instanceRemapBuffer.id);
+
+    // a single workgroup scans all buckets
+    glProgramUniform1i(cs.id, 0, 0);
+    glDispatchCompute(1, 1, 1);
+    glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glProgramUniform1i(cs.id, 0, 1);
+    glDispatchCompute(static_cast<uint32_t>((frame.drawableCount + 255) / 256), 1, 1);
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    glBindProgramPipeline(0);
+}
+
+// Writes the commands of `phase` into its own range of the indirect buffer, the disocclusion phase right after the first one.
+static auto cullDrawables(Device& device, const FrameState& frame, CullingPhase phase) -> bool {
+    auto pipeline = findPipeline(device, CullingPipelineTag);
+    if (!pipeline || device.meshProperties_.empty()) {
         loadPipeline(device, CullingPipelineTag, std::array { CullingShaderName });
+        return false;
     }
 
-    static int visibleInstances = 0;
-    static float timeToShowCulledInstances = 0.0f;
-    timeToShowCulledInstances += 0.016f;
-    if (timeToShowCulledInstances >= 1.0f) {
-        timeToShowCulledInstances = 0.f;
+    // one workgroup per drawable, wrapped into a second dimension past the dispatch size limit
+    const auto workgroupCountX = static_cast<uint32_t>(std::min<size_t>(frame.drawableCount, MaxWorkgroupCount));
+    const auto workgroupCountY
+        = workgroupCountX != 0 ? static_cast<uint32_t>((frame.drawableCount + workgroupCountX - 1) / workgroupCountX) : 0;
+
+    const bool disocclusion = phase == CullingPhase::Disocclusion;
+    const auto& occlusionView = disocclusion ? frame.view : device.depthPyramidView;
+    const auto& occlusionProjection = disocclusion ? frame.projection : device.depthPyramidProjection;
+
+    glBindProgramPipeline(pipeline.id);
+
+    auto cs = findShader(device, make_hash(CullingShaderName));
+
+    glProgramUniform1f(cs.id, 0, frame.fieldOfView);
+    glProgramUniform1f(cs.id, 1, frame.aspectRatio);
+    glProgramUniform1f(cs.id, 2, frame.nearPlane);
+    glProgramUniform1f(cs.id, 3, frame.farPlane);
+    glProgramUniformMatrix4fv(cs.id, 4, 1, false, &frame.view[0][0]);
+    glProgramUniform1i(cs.id, 5, device.culling ? 0 : 1);
+    glProgramUniformMatrix4fv(cs.id, 6, 1, false, &occlusionView[0][0]);
+    glProgramUniformMatrix4fv(cs.id, 7, 1, false, &occlusionProjection[0][0]);
+    glProgramUniform1i(cs.id, 8, static_cast<int32_t>(phase));
+    glProgramUniform1ui(cs.id, 9, disocclusion ? frame.commandCount : 0);
+    glProgramUniform1i(cs.id, 10, frame.compactCommands);
+    glProgramUniform1i(cs.id, 11, frame.mergeInstances);
+    glProgramUniform1f(cs.id, 12, frame.projection[1][1] * 0.5f * static_cast<float>(device.framebuffers_[1].height));
+    glProgramUniform1f(cs.id, 13, device.lodPixelThreshold);
 
-        visibleInstances = 0;
+    auto meshPropertyBuffer = findBuffer(device, MeshPropertyBufferTag);
+    auto meshletBuffer = findBuffer(device, MeshletBufferTag);
+    auto occlusionBuffer = findBuffer(device, OcclusionBufferTag);
+    auto cullingStatsBuffer = findBuffer(device, CullingStatsBufferTag);
+    auto depthPyramid = findTexture(device, DepthPyramidTextureTag);
+
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, frame.instanceBuffer.id, 0, frame.instanceDataSize);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, frame.indirectBuffer.id);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 3, frame.drawableBuffer.id, 0, frame.drawableDataSize);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 6, meshPropertyBuffer.id, 0, std::size(device.meshProperties_) * sizeof(MeshProperty));
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 8, meshletBuffer.id);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 9, occlusionBuffer.id);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 10, cullingStatsBuffer.id);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 11, frame.drawCountBuffer.id);
+
+    auto instanceSlotBuffer = findBuffer(device, InstanceSlotBufferTag);
+    auto instanceBucketBuffer = findBuffer(device, InstanceBucketBufferTag);
+
+    if (frame.mergeInstances) {
+        // every phase buckets its own visible instances
+        const uint32_t hidden = 0xffffffff;
+        glClearNamedBufferData(instanceSlotBuffer.id, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, &hidden);
+        glClearNamedBufferData(instanceBucketBuffer.id, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 13, instanceSlotBuffer.id);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 14, instanceBucketBuffer.id);
+    }
 
-        std::vector<DrawElementsIndirectCommand> cmds;
-        cmds.resize(instanceCount);
+    glBindTextureUnit(0, depthPyramid.id);
 
-        glGetNamedBufferSubData(indirectBuffer.id, 0, std::size(cmds) * sizeof(DrawElementsIndirectCommand), std::data(cmds));
+    glDispatchCompute(workgroupCountX, workgroupCountY, 1);
 
-        for (const auto& cmd : cmds) {
-            visibleInstances += cmd.instanceCount;
-        }
+    glBindTextureUnit(0, 0);
+    glBindProgramPipeline(0);
+
+    // the disocclusion phase reads the occlusion flags the first phase wrote
+    glMemoryBarrier(GL_COMMAND_BARRIER_BIT | GL_SHADER_STORAGE_BARRIER_BIT);
+
+    if (frame.mergeInstances) {
+        mergeInstances(device, frame, phase);
+    }
+
+    return true;
+}
 
-        device.visibleInstances = visibleInstances;
+// Downsamples the scene depth into the depth pyramid, one dispatch per level.
+static auto buildDepthPyramid(Device& device) -> bool {
+    auto pipeline = findPipeline(device, DepthPyramidPipelineTag);
+    if (!pipeline) {
+        loadPipeline(device, DepthPyramidPipelineTag, std::array { DepthPyramidShaderName });
+        return false;
     }
 
+    auto cs = findShader(device, make_hash(DepthPyramidShaderName));
+    auto sceneDepthTexture = findTexture(device, SceneDepthTextureTag);
+    auto depthPyramid = findTexture(device, DepthPyramidTextureTag);
+
+    glBindProgramPipeline(pipeline.id);
+
+    for (uint32_t level = 0; level < depthPyramid.mipLevels; level++) {
+        const uint32_t width = std::max(depthPyramid.width >> level, 1u);
+        const uint32_t height = std::max(depthPyramid.height >> level, 1u);
+
+        // the first level reads the scene depth, every other one the level above it
+        glBindTextureUnit(0, level == 0 ? sceneDepthTexture.id : depthPyramid.id);
+        glProgramUniform1i(cs.id, 0, level == 0 ? 0 : static_cast<int32_t>(level) - 1);
+        glBindImageTexture(0, depthPyramid.id, static_cast<GLint>(level), GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+        glDispatchCompute((width + 7) / 8, (height + 7) / 8, 1);
+        glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+    }
+
+    glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+    glBindTextureUnit(0, 0);
+    glBindProgramPipeline(0);
+
+    return true;
+}
+
+// Submits the commands one culling phase wrote into command range `range` of the indirect buffer.
+static auto drawCommandRange(const FrameState& frame, uint32_t range) -> void {
+    const auto firstCommand = static_cast<size_t>(range) * frame.commandCount;
+    const auto indirectOffset
+        = reinterpret_cast<const void*>(static_cast<uintptr_t>(firstCommand * sizeof(DrawElementsIndirectCommand)));
+    const auto maxDrawCount = static_cast<GLsizei>(frame.commandCount);
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, frame.indirectBuffer.id);
+
+    if (frame.compactCommands) {
+        glBindBuffer(GL_PARAMETER_BUFFER, frame.drawCountBuffer.id);
+        glMultiDrawElementsIndirectCount(GL_TRIANGLES, GL_UNSIGNED_INT, indirectOffset, range * sizeof(uint32_t), maxDrawCount,
+            sizeof(DrawElementsIndirectCommand));
+        glBindBuffer(GL_PARAMETER_BUFFER, 0);
+    } else {
+        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, indirectOffset, maxDrawCount, sizeof(DrawElementsIndirectCommand));
+    }
+
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+// Draws command range `range` into the bound scene framebuffer.
+static auto drawScene(Device& device, const FrameState& frame, uint32_t range) -> void {
+
     //
-    // render objects
+    // depth prepass, fetching positions only so that shading runs once per covered pixel
     //
+    bool depthPrepassDone = false;
+    if (device.depthPrepass) {
+        if (auto pipeline = findPipeline(device, DepthPipelineTag); pipeline) {
+            glBindProgramPipeline(pipeline.id);
+            glBindVertexArray(device.positionVertexArray);
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 
-    const auto clearColor = std::array { 0.1f, 0.1f, 0.1f, 1.f };
-    const auto clearDepth = 1.f;
+            auto vs = findShader(device, make_hash(DepthShaderName));
+            auto meshPropertyBuffer = findBuffer(device, MeshPropertyBufferTag);
+            auto instanceRemapBuffer = findBuffer(device, InstanceRemapBufferTag);
 
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glCullFace(GL_BACK);
+            glProgramUniformMatrix4fv(vs.id, 0, 1, false, &frame.projection[0][0]);
+            glProgramUniformMatrix4fv(vs.id, 1, 1, false, &frame.view[0][0]);
+            glProgramUniform1i(vs.id, 2, frame.mergeInstances);
 
-    glBindFramebuffer(GL_FRAMEBUFFER, device.framebuffers_[1].id);
-    glViewport(0, 0, device.framebuffers_[1].width, device.framebuffers_[1].height);
-    glClearNamedFramebufferfv(device.framebuffers_[1].id, GL_COLOR, 0, std::data(clearColor));
-    glClearNamedFramebufferfv(device.framebuffers_[1].id, GL_DEPTH, 0, &clearDepth);
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, frame.instanceBuffer.id, 0, frame.instanceDataSize);
+            glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 3, frame.drawableBuffer.id, 0, frame.drawableDataSize);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, meshPropertyBuffer.id);
+            glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, instanceRemapBuffer.id);
+
+            drawCommandRange(frame, range);
+
+            glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+            glBindVertexArray(0);
+            glBindProgramPipeline(0);
+
+            depthPrepassDone = true;
+        } else {
+            loadPipeline(device, DepthPipelineTag, std::array { DepthShaderName });
+        }
+    }
 
     if (auto pipeline = findPipeline(device, MeshPipelineTag); pipeline) {
         glBindProgramPipeline(pipeline.id);
         glBindVertexArray(device.meshVertexArray);
 
-        const vec3 viewPos = camera.position();
-
         auto vs = findShader(device, make_hash(MeshShaderNames[0]));
         auto fs = findShader(device, make_hash(MeshShaderNames[1]));
 
@@ -709,29 +1314,41 @@ auto present(Device& device, Camera& camera, std::span<const Entity> entities) -
         auto prefilterCubemap = findTexture(device, PrefilterCubemapTag);
         auto brdfLUTTexture = findTexture(device, brdfLUTTextureTag);
 
-        auto indirectBuffer = findBuffer(device, IndirectBufferTag);
-        auto drawableBuffer = findBuffer(device, DrawableBufferTag);
         auto materialBuffer = findBuffer(device, MaterialBufferTag);
         auto textureHandleBuffer = findBuffer(device, TextureHandleBufferTag);
         auto lightBuffer = findBuffer(device, LightBufferTag);
+        auto meshPropertyBuffer = findBuffer(device, MeshPropertyBufferTag);
+        auto instanceRemapBuffer = findBuffer(device, InstanceRemapBufferTag);
 
-        glProgramUniformMatrix4fv(vs.id, 0, 1, false, &projection[0][0]);
-        glProgramUniformMatrix4fv(vs.id, 1, 1, false, &view[0][0]);
-        glProgramUniform3fv(fs.id, 1, 1, &viewPos[0]);
+        glProgramUniformMatrix4fv(vs.id, 0, 1, false, &frame.projection[0][0]);
+        glProgramUniformMatrix4fv(vs.id, 1, 1, false, &frame.view[0][0]);
+        glProgramUniform1i(vs.id, 2, device.quantizeVertices);
+        glProgramUniform1i(vs.id, 3, frame.mergeInstances);
+        glProgramUniform3fv(fs.id, 1, 1, &frame.viewPosition[0]);
         glProgramUniform1i(fs.id, 2, true);
 
         glBindTextureUnit(10, irradianceCubemap.id);
         glBindTextureUnit(11, prefilterCubemap.id);
         glBindTextureUnit(12, brdfLUTTexture.id);
 
-        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, drawableBuffer.id);
+        // the prepass already resolved visibility, only the nearest surface is shaded
+        if (depthPrepassDone) {
+            glDepthFunc(GL_EQUAL);
+            glDepthMask(GL_FALSE);
+        }
+
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, frame.instanceBuffer.id, 0, frame.instanceDataSize);
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 3, frame.drawableBuffer.id, 0, frame.drawableDataSize);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 4, materialBuffer.id);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 5, textureHandleBuffer.id);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 6, meshPropertyBuffer.id);
         glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 7, lightBuffer.id);
+        glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 12, instanceRemapBuffer.id);
+
+        drawCommandRange(frame, range);
 
-        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer.id);
-        glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, nullptr, instanceCount, sizeof(DrawElementsIndirectCommand));
-        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        glDepthFunc(GL_LESS);
+        glDepthMask(GL_TRUE);
 
         glBindTextureUnit(10, 0);
         glBindTextureUnit(11, 0);
@@ -742,6 +1359,163 @@ auto present(Device& device, Camera& camera, std::span<const Entity> entities) -
     } else {
         loadPipeline(device, MeshPipelineTag, MeshShaderNames);
     }
+}
+
+// Queues a copy of this frame's culling counters into the readback ring and publishes the newest frame whose copy completed,
+// a few frames late and without ever waiting on the GPU.
+static auto readCullingStats(Device& device, const FrameState& frame) -> void {
+    auto& ring = device.cullingReadback_;
+
+    if (const auto offset = beginReadbackFrame(ring); offset) {
+        auto cullingStatsBuffer = findBuffer(device, CullingStatsBufferTag);
+
+        // the counters were written by shader atomics
+        glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT);
+        glCopyNamedBufferSubData(cullingStatsBuffer.id, ring.id, 0, *offset + offsetof(CullingReadback, stats), sizeof(CullingStats));
+        glCopyNamedBufferSubData(frame.drawCountBuffer.id, ring.id, 0, *offset + offsetof(CullingReadback, drawCounts),
+            sizeof(CullingReadback::drawCounts));
+
+        endReadbackFrame(ring);
+    }
+
+    const auto results = pollReadbackFrame(ring);
+    if (std::size(results) < sizeof(CullingReadback)) {
+        return;
+    }
+
+    CullingReadback readback;
+    std::memcpy(&readback, std::data(results), sizeof(readback));
+
+    const auto& stats = readback.stats;
+    device.visibleInstances = static_cast<int32_t>(stats.visibleInstances);
+    device.visibleMeshlets = static_cast<int32_t>(stats.visibleMeshlets);
+    device.drawCommands = static_cast<int32_t>(readback.drawCounts[0] + readback.drawCounts[1]);
+    device.frustumCulledInstances = static_cast<int32_t>(stats.frustumCulledInstances);
+    device.occludedInstances = static_cast<int32_t>(stats.occludedInstances);
+    device.disoccludedInstances = static_cast<int32_t>(stats.disoccludedInstances);
+    device.renderedTriangles = stats.renderedTriangles;
+    std::ranges::copy(stats.lodInstances, std::begin(device.lodInstances));
+}
+
+auto present(Device& device, Camera& camera) -> void {
+    assert(!device.framebuffers_.empty());
+
+    if (!device.buildedEnvCubemap || !device.buildedIrradianceCubemap || !device.buildPrefilterCubemap || !device.buildBRDFLUTTexture) {
+        buildEnvironmentCubemap(device);
+    }
+
+    const float aspectRation = static_cast<float>(device.framebuffers_[0].width) / static_cast<float>(device.framebuffers_[0].height);
+
+    mat4 projection = camera.projection(aspectRation);
+    mat4 view = camera.view();
+
+    updateTextureStreamer(device.textureStreamer_, *device.jobSystem_);
+    updateMaterialBuffers(device);
+    updateMeshBuffers(device);
+    updateLightBuffer(device);
+    updateModelTransforms(device);
+    updateEntityTransforms(device);
+    updateSceneBuffers(device);
+
+    // the culling pass walks every drawable slot, empty ones return right away
+    const size_t drawableCount = device.drawableAllocator_.capacity();
+    const uint32_t commandCount = device.commandAllocator_.capacity();
+
+    const size_t instanceDataSize = std::max<size_t>(drawableCount, 1) * sizeof(mat4);
+    const size_t drawableDataSize = std::max<size_t>(drawableCount, 1) * sizeof(Drawable);
+
+    device.drawInstances = static_cast<int32_t>(device.drawableAllocator_.stats().usedSize);
+
+    // the disocclusion phase writes its commands into a second range after the first one
+    const bool occlusionCulling = device.culling && device.occlusionCulling;
+    if (!occlusionCulling) {
+        device.depthPyramidValid = false;
+    }
+
+    // merged instances take a command per mesh LOD, instead of a command range per drawable
+    const auto bucketCount = static_cast<uint32_t>(std::size(device.meshProperties_) * MaxMeshLODs);
+    const uint32_t rangeSize = device.mergeInstances ? bucketCount : commandCount;
+
+    const size_t commandRanges = occlusionCulling ? 2 : 1;
+    const size_t indirectDataSize = std::max<size_t>(rangeSize * commandRanges, 1) * sizeof(DrawElementsIndirectCommand);
+
+    const FrameState frame { .projection = projection,
+        .view = view,
+        .viewPosition = camera.position(),
+        .fieldOfView = glm::radians(camera.fieldOfView),
+        .aspectRatio = aspectRation,
+        .nearPlane = camera.nearPlane,
+        .farPlane = camera.farPlane,
+        .drawableCount = drawableCount,
+        .instanceBuffer = findBuffer(device, InstanceBufferTag),
+        .instanceDataSize = instanceDataSize,
+        .drawableBuffer = findBuffer(device, DrawableBufferTag),
+        .drawableDataSize = drawableDataSize,
+        .commandCount = rangeSize,
+        .indirectBuffer = reserveBuffer(device, IndirectBufferTag, indirectDataSize),
+        .compactCommands = device.compactDraws && device.supportsDrawIndirectCount,
+        .drawCountBuffer = findBuffer(device, DrawCountBufferTag),
+        .mergeInstances = device.mergeInstances };
+
+    reserveBuffer(device, OcclusionBufferTag, std::max<size_t>(drawableCount, 1) * sizeof(uint32_t));
+    reserveBuffer(device, InstanceRemapBufferTag, std::max<size_t>(drawableCount * commandRanges, 1) * sizeof(uint32_t));
+    reserveBuffer(device, InstanceSlotBufferTag, std::max<size_t>(drawableCount, 1) * sizeof(uvec2));
+    reserveBuffer(device, InstanceBucketBufferTag, std::max<size_t>(bucketCount, 1) * sizeof(uvec2));
+
+    auto cullingStatsBuffer = findBuffer(device, CullingStatsBufferTag);
+    glClearNamedBufferData(cullingStatsBuffer.id, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    glClearNamedBufferData(frame.drawCountBuffer.id, GL_R32UI, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+
+    // the culling pass never writes the command ranges of destroyed entities, so fixed ranges start out as empty commands
+    if (!frame.compactCommands && !frame.mergeInstances && device.commandAllocator_.stats().freeSize != 0) {
+        glClearNamedBufferSubData(frame.indirectBuffer.id, GL_R32UI, 0, indirectDataSize, GL_RED_INTEGER, GL_UNSIGNED_INT, nullptr);
+    }
+
+    // the draw counts always hold the commands each range submits, whole ranges when they are not packed
+    if (!frame.compactCommands) {
+        glNamedBufferSubData(frame.drawCountBuffer.id, 0, sizeof(uint32_t), &frame.commandCount);
+    }
+
+    //
+    // render objects
+    //
+
+    const auto clearColor = std::array { 0.1f, 0.1f, 0.1f, 1.f };
+    const auto clearDepth = 1.f;
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glCullFace(GL_BACK);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, device.framebuffers_[1].id);
+    glViewport(0, 0, device.framebuffers_[1].width, device.framebuffers_[1].height);
+    glClearNamedFramebufferfv(device.framebuffers_[1].id, GL_COLOR, 0, std::data(clearColor));
+    glClearNamedFramebufferfv(device.framebuffers_[1].id, GL_DEPTH, 0, &clearDepth);
+
+    //
+    // cull and draw what the previous depth pyramid doesn't hide, rebuild the pyramid from that depth and draw what it
+    // wrongly hid, so objects coming into view appear in the same frame
+    //
+    const auto firstPhase = occlusionCulling && device.depthPyramidValid ? CullingPhase::Occlusion : CullingPhase::Frustum;
+    const bool culled = cullDrawables(device, frame, firstPhase);
+    drawScene(device, frame, 0);
+
+    if (occlusionCulling && culled && buildDepthPyramid(device)) {
+        if (firstPhase == CullingPhase::Occlusion) {
+            cullDrawables(device, frame, CullingPhase::Disocclusion);
+            drawScene(device, frame, 1);
+
+            if (!frame.compactCommands) {
+                glNamedBufferSubData(frame.drawCountBuffer.id, sizeof(uint32_t), sizeof(uint32_t), &frame.commandCount);
+            }
+        }
+
+        device.depthPyramidView = view;
+        device.depthPyramidProjection = projection;
+        device.depthPyramidValid = true;
+    }
+
+    readCullingStats(device, frame);
 
     glCullFace(GL_FRONT);
 
@@ -1,6 +1,13 @@
 #pragma once
 
+#include "DirtyRanges.hpp"
 #include "Graphics.hpp"
+#include "JobSystem.hpp"
+#include "RangeAllocator.hpp"
+#include "RingBuffer.hpp"
+#include "TagIndex.hpp"
+#include "TextureStreamer.hpp"
+#include "TransformStore.hpp"
 
 typedef struct GLFWwindow GLFWwindow;
 
@@ -29,14 +36,33 @@ struct Camera {
         return glm::perspective(glm::radians(fieldOfView), aspectRation, nearPlane, farPlane);
     }
 };
+
 struct Entity {
-    mat4 transform { 1.f };
-    uint32_t modelRef { 0xffffffff };
+    Transform transform {};
+    ModelRef modelRef {};
+};
+
+// An entity of the retained scene. Its drawables, one per submesh of the model, and their indirect command ranges keep their
+// slots until the entity is destroyed, so a frame only uploads what was created, moved or destroyed since the last one.
+struct SceneEntity {
+    ModelRef modelRef;
+    RangeAllocation drawables;
+    RangeAllocation commands;
 };
 
 struct Drawable {
     uint32_t materialRef { 0xffffffff };
     uint32_t meshRef { 0xffffffff };
+    // indirect commands reserved for the drawable, one per meshlet of its largest LOD
+    uint32_t firstCommand { 0 };
+    uint32_t commandCount { 0 };
+};
+
+// Vertex, index and meshlet ranges a mesh occupies in the mega-buffers, all LODs back to back.
+struct MeshAllocation {
+    RangeAllocation vertices;
+    RangeAllocation indices;
+    RangeAllocation meshlets;
 };
 
 struct DebugOutputParams {
@@ -54,35 +80,122 @@ struct Device {
 
     std::vector<Model> models_;
 
-    std::vector<Vertex> vertices_;
+    SlotAllocator<TextureSlot> textureSlots_;
+    SlotAllocator<TextureHandleSlot> textureHandleSlots_;
+    SlotAllocator<MeshSlot> meshSlots_;
+    SlotAllocator<MaterialSlot> materialSlots_;
+    SlotAllocator<ModelSlot> modelSlots_;
+
+    TagIndex textureIndex_;
+    TagIndex shaderIndex_;
+    TagIndex pipelineIndex_;
+    TagIndex bufferIndex_;
+    TagIndex textureHandleIndex_;
+    TagIndex textureContentIndex_;
+    TagIndex modelIndex_;
+    TagIndex meshIndex_;
+
+    // CPU mirrors of the vertex stream and index mega-buffers, sized to the allocator capacity with holes where meshes were
+    // removed; only the float or the packed vertex mirrors are used, depending on quantizeVertices
+    std::vector<vec3> positions_;
+    std::vector<VertexAttributes> vertexAttributes_;
+    std::vector<PackedPosition> packedPositions_;
+    std::vector<PackedAttributes> packedAttributes_;
     std::vector<uint32_t> indices_;
+    std::vector<Meshlet> meshlets_;
+    RangeAllocator vertexAllocator_;
+    RangeAllocator indexAllocator_;
+    RangeAllocator meshletAllocator_;
+    std::vector<MeshAllocation> meshAllocations_;
+    // content hash and owner count of every mesh, identical geometry is stored once
+    std::vector<uint64_t> meshHashes_;
+    std::vector<uint32_t> meshRefCounts_;
     std::vector<Material> materials_;
     std::vector<uint64_t> textureHandles_;
+    // owner count of every texture, and the content key of shareable ones
+    std::vector<uint32_t> textureRefCounts_;
+    std::vector<uint64_t> textureContentKeys_;
     std::vector<MeshProperty> meshProperties_;
     std::vector<Light> lights_;
 
-    std::vector<mat4> modelMatrices_;
+    // retained scene; drawable slots without an entity keep an invalid mesh and are skipped by the culling pass
+    SlotAllocator<EntitySlot> entitySlots_;
+    std::vector<SceneEntity> entities_;
+    // indexed by entity slot, composed into world matrices in batches when they changed
+    TransformStore entityTransforms_;
+    std::vector<mat4> entityMatrices_;
+    std::vector<mat4> instanceTransforms_;
     std::vector<Drawable> drawables_;
+    RangeAllocator drawableAllocator_;
+    RangeAllocator commandAllocator_;
+    // culling counters on their way back to the CPU
+    ReadbackRing cullingReadback_;
+    // staging for the changed ranges of the resident instance and drawable buffers
+    RingBuffer sceneStagingRing_;
+
+    std::unique_ptr<JobSystem> jobSystem_;
+    TextureStreamer textureStreamer_;
 
     uint32_t meshVertexArray { 0 };
+    // positions and instance matrices only, for depth-only passes
+    uint32_t positionVertexArray { 0 };
     uint32_t fullscreenQuadVertexArray { 0 };
 
     float gamma { 2.2f };
     float exposure { 1.f };
     bool culling { true };
+    bool depthPrepass { false };
+    bool occlusionCulling { true };
+    // pack visible commands and draw them with a GPU written count, when the context supports it
+    bool compactDraws { true };
+    bool supportsDrawIndirectCount { false };
+    // draw every visible LOD of a mesh as one instanced command, giving up per-meshlet culling
+    bool mergeInstances { true };
+    // how many pixels the simplification error of the selected LOD may cover on screen
+    float lodPixelThreshold { 1.f };
     bool useBindlessTextures { true };
+    bool quantizeVertices { true };
+    bool bakeTexturesOnLoad { false };
     int32_t visibleInstances { 0 };
+    int32_t visibleMeshlets { 0 };
     int32_t drawInstances { 0 };
-
-    bool reloadMeshBuffers_ { true };
-    bool reloadMaterialBuffers_ { true };
-    bool reloadLightBuffers_ { true };
+    int32_t drawCommands { 0 };
+    int32_t frustumCulledInstances { 0 };
+    // rejected by the depth pyramid of the previous frame, and the part of those the current one showed visible
+    int32_t occludedInstances { 0 };
+    int32_t disoccludedInstances { 0 };
+    uint32_t renderedTriangles { 0 };
+    // meshes that were added again and shared the stored one, and the geometry bytes that saved
+    uint32_t sharedMeshes { 0 };
+    size_t sharedMeshBytes { 0 };
+    // textures in video memory, and the references that shared one of them instead of creating a copy
+    uint32_t residentTextures { 0 };
+    size_t residentTextureBytes { 0 };
+    uint32_t sharedTextures { 0 };
+    size_t sharedTextureBytes { 0 };
+    std::array<uint32_t, MaxMeshLODs> lodInstances {};
+
+    DirtyRanges dirtyVertices_;
+    DirtyRanges dirtyIndices_;
+    DirtyRanges dirtyMeshlets_;
+    DirtyRanges dirtyMeshProperties_;
+    DirtyRanges dirtyMaterials_;
+    DirtyRanges dirtyTextureHandles_;
+    DirtyRanges dirtyLights_;
+    DirtyRanges dirtyEntityTransforms_;
+    DirtyRanges dirtyInstanceTransforms_;
+    DirtyRanges dirtyDrawables_;
 
     bool buildedEnvCubemap { false };
     bool buildedIrradianceCubemap { false };
     bool buildPrefilterCubemap { false };
     bool buildBRDFLUTTexture { false };
 
+    // view and projection the depth pyramid was last built with
+    mat4 depthPyramidView { 1.f };
+    mat4 depthPyramidProjection { 1.f };
+    bool depthPyramidValid { false };
+
     DebugOutputParams debugOutputParams_;
 };
 
@@ -97,17 +210,37 @@ struct DeviceConfiguration {
 
     size_t numVertices { 0 };
     size_t numIndices { 0 };
+    size_t numMeshlets { 0 };
+
+    // store meshes as packed positions and attributes instead of full floats
+    bool quantizeVertices { true };
 
     size_t numMaterials { 0 };
     size_t numMeshes { 0 };
     size_t numLights { 0 };
     size_t numModels { 0 };
     size_t numEntities { 0 };
+
+    // threads used for asset processing, 0 uses every hardware core
+    size_t numJobThreads { 0 };
+
+    // pixel staging ring for streamed textures and the bytes it may stage per frame
+    size_t textureStagingSize { 64 << 20 };
+    size_t textureUploadBudget { 8 << 20 };
+    // block compress glTF images without a fresh baked texture while loading, instead of leaving that to TextureBaker; writes
+    // the baked textures next to the assets
+    bool bakeTexturesOnLoad { false };
 };
 
 auto initialize(Device& device, const DeviceConfiguration& conf) -> bool;
 auto cleanup(Device& device) -> void;
-auto present(Device& device, Camera& camera, std::span<const Entity> entities) -> void;
+
+// Entities reference a live model and have to be destroyed before it.
+auto createEntity(Device& device, const Entity& entity) -> EntityRef;
+auto updateEntity(Device& device, EntityRef ref, const Transform& transform) -> bool;
+auto destroyEntity(Device& device, EntityRef ref) -> bool;
+
+auto present(Device& device, Camera& camera) -> void;
 auto resize(Device& device, const ivec2& framebufferSize) -> void;
 
 } // namespace Graphics
\ No newline at end of file
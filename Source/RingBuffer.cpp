@@ -0,0 +1,145 @@
+#include "RingBuffer.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+
+namespace Graphics {
+
+static auto waitFence(void*& fence) -> void {
+    if (!fence) {
+        return;
+    }
+
+    const auto sync = reinterpret_cast<GLsync>(fence);
+
+    GLbitfield flags = 0;
+    for (;;) {
+        const auto result = glClientWaitSync(sync, flags, 1'000'000);
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED) {
+            break;
+        }
+
+        flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    }
+
+    glDeleteSync(sync);
+    fence = nullptr;
+}
+
+auto createRingBuffer(const RingBufferConfiguration& conf) -> RingBuffer {
+    GLint alignment = 256;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    alignment = std::max(alignment, 256);
+
+    const size_t frameSize = (std::max<size_t>(conf.frameSize, 1) + alignment - 1) / alignment * alignment;
+    const size_t totalSize = frameSize * MaxFramesInFlight;
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    auto id = 0u;
+    glCreateBuffers(1, &id);
+    glNamedBufferStorage(id, totalSize, nullptr, flags);
+
+    auto mapped = reinterpret_cast<uint8_t*>(glMapNamedBufferRange(id, 0, totalSize, flags));
+
+    return { .tag = conf.tag, .id = id, .frameIndex = 0, .frameSize = frameSize, .mapped = mapped };
+}
+
+auto destroyRingBuffer(RingBuffer& ring) -> void {
+    for (auto& fence : ring.fences) {
+        waitFence(fence);
+    }
+
+    if (ring.id != 0) {
+        glUnmapNamedBuffer(ring.id);
+        glDeleteBuffers(1, &ring.id);
+    }
+
+    ring = {};
+}
+
+auto acquireRingBufferFrame(RingBuffer& ring, size_t size) -> std::span<uint8_t> {
+    if (size > ring.frameSize) {
+        const auto tag = ring.tag;
+        const auto frameSize = std::max(size, ring.frameSize * 2);
+
+        destroyRingBuffer(ring);
+        ring = createRingBuffer({ .tag = tag, .frameSize = frameSize });
+    }
+
+    waitFence(ring.fences[ring.frameIndex]);
+
+    return { ring.mapped + ringBufferOffset(ring), size };
+}
+
+auto releaseRingBufferFrame(RingBuffer& ring) -> void {
+    ring.fences[ring.frameIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ring.frameIndex = (ring.frameIndex + 1) % MaxFramesInFlight;
+}
+
+auto createReadbackRing(size_t frameSize) -> ReadbackRing {
+    const size_t size = std::max<size_t>(frameSize, 1);
+    const size_t totalSize = size * MaxFramesInFlight;
+
+    constexpr GLbitfield flags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    auto id = 0u;
+    glCreateBuffers(1, &id);
+    glNamedBufferStorage(id, totalSize, nullptr, flags);
+
+    auto mapped = reinterpret_cast<const uint8_t*>(glMapNamedBufferRange(id, 0, totalSize, flags));
+
+    return { .id = id, .frameSize = size, .mapped = mapped };
+}
+
+auto destroyReadbackRing(ReadbackRing& ring) -> void {
+    for (auto& fence : ring.fences) {
+        waitFence(fence);
+    }
+
+    if (ring.id != 0) {
+        glUnmapNamedBuffer(ring.id);
+        glDeleteBuffers(1, &ring.id);
+    }
+
+    ring = {};
+}
+
+auto beginReadbackFrame(const ReadbackRing& ring) -> std::optional<size_t> {
+    if (ring.pendingCount == MaxFramesInFlight) {
+        return std::nullopt;
+    }
+
+    return ring.writeIndex * ring.frameSize;
+}
+
+auto endReadbackFrame(ReadbackRing& ring) -> void {
+    ring.fences[ring.writeIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    ring.writeIndex = (ring.writeIndex + 1) % MaxFramesInFlight;
+    ring.pendingCount++;
+}
+
+auto pollReadbackFrame(ReadbackRing& ring) -> std::span<const uint8_t> {
+    std::span<const uint8_t> newest;
+
+    while (ring.pendingCount != 0) {
+        const uint32_t index = (ring.writeIndex + MaxFramesInFlight - ring.pendingCount) % MaxFramesInFlight;
+        const auto sync = reinterpret_cast<GLsync>(ring.fences[index]);
+
+        const auto result = glClientWaitSync(sync, 0, 0);
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+            break;
+        }
+
+        glDeleteSync(sync);
+        ring.fences[index] = nullptr;
+        ring.pendingCount--;
+
+        newest = { ring.mapped + index * ring.frameSize, ring.frameSize };
+    }
+
+    return newest;
+}
+
+} // namespace Graphics
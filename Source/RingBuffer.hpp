@@ -0,0 +1,84 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+
+namespace Graphics {
+
+constexpr uint32_t MaxFramesInFlight = 3;
+
+// Persistently mapped buffer split into MaxFramesInFlight regions.
+// The CPU writes the current region while the GPU still reads the previous ones; a fence per region keeps them apart.
+struct RingBuffer {
+    auto is_valid() const noexcept -> bool {
+        return id != 0;
+    }
+
+    operator bool() const {
+        return is_valid();
+    }
+
+    uint64_t tag = 0;
+    uint32_t id = 0;
+    uint32_t frameIndex = 0;
+    size_t frameSize = 0;
+    uint8_t* mapped = nullptr;
+    std::array<void*, MaxFramesInFlight> fences {};
+};
+
+struct RingBufferConfiguration {
+    uint64_t tag;
+    size_t frameSize = 0;
+};
+
+auto createRingBuffer(const RingBufferConfiguration& conf) -> RingBuffer;
+auto destroyRingBuffer(RingBuffer& ring) -> void;
+
+// Waits until the GPU is done with the current region and returns `size` writable bytes of it.
+// The buffer is reallocated with doubled capacity when a frame needs more than `frameSize` bytes.
+auto acquireRingBufferFrame(RingBuffer& ring, size_t size) -> std::span<uint8_t>;
+
+// Fences the commands that read the current region and moves on to the next one.
+auto releaseRingBufferFrame(RingBuffer& ring) -> void;
+
+inline auto ringBufferOffset(const RingBuffer& ring) -> size_t {
+    return ring.frameIndex * ring.frameSize;
+}
+
+// Persistently mapped buffer the GPU copies small per-frame results into, one region per frame in flight.
+// The CPU reads a region once its fence signaled and never waits for one, so results arrive a few frames late without stalls.
+struct ReadbackRing {
+    auto is_valid() const noexcept -> bool {
+        return id != 0;
+    }
+
+    operator bool() const {
+        return is_valid();
+    }
+
+    uint32_t id = 0;
+    // next region to copy into, and how many regions before it are still waiting to be read
+    uint32_t writeIndex = 0;
+    uint32_t pendingCount = 0;
+    size_t frameSize = 0;
+    const uint8_t* mapped = nullptr;
+    std::array<void*, MaxFramesInFlight> fences {};
+};
+
+auto createReadbackRing(size_t frameSize) -> ReadbackRing;
+auto destroyReadbackRing(ReadbackRing& ring) -> void;
+
+// Offset of the region to copy this frame's results into, or nullopt when every region is still waiting to be read.
+auto beginReadbackFrame(const ReadbackRing& ring) -> std::optional<size_t>;
+
+// Fences the copies into the region beginReadbackFrame returned.
+auto endReadbackFrame(ReadbackRing& ring) -> void;
+
+// Releases every region whose copies completed and returns the newest of them, or an empty span when none did.
+// The span stays valid until that region is written again, MaxFramesInFlight frames later at the earliest.
+auto pollReadbackFrame(ReadbackRing& ring) -> std::span<const uint8_t>;
+
+} // namespace Graphics
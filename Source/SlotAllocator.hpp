@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Graphics {
+
+// Generational reference to a slot in one of the Device resource vectors.
+// The index is stable for the lifetime of the resource and is what GPU-side tables use; the generation detects stale references
+// after the slot was destroyed and recycled.
+template <typename T> struct Handle {
+    static constexpr uint32_t InvalidIndex = 0xffffffff;
+
+    auto is_valid() const noexcept -> bool {
+        return index != InvalidIndex;
+    }
+
+    operator bool() const {
+        return is_valid();
+    }
+
+    auto operator==(const Handle&) const -> bool = default;
+
+    uint32_t index { InvalidIndex };
+    uint32_t generation { 0 };
+};
+
+// Hands out slot indices for a resource vector and recycles destroyed ones.
+// It only tracks slot bookkeeping; the resources themselves stay in plain vectors so they can be uploaded to the GPU as is.
+template <typename T> struct SlotAllocator {
+    auto allocate() -> Handle<T> {
+        if (!freeList_.empty()) {
+            const auto index = freeList_.back();
+            freeList_.pop_back();
+
+            return { index, generations_[index] };
+        }
+
+        generations_.push_back(1);
+
+        return { static_cast<uint32_t>(std::size(generations_) - 1), 1 };
+    }
+
+    auto release(Handle<T> handle) -> bool {
+        if (!contains(handle)) {
+            return false;
+        }
+
+        generations_[handle.index]++;
+        freeList_.push_back(handle.index);
+
+        return true;
+    }
+
+    auto contains(Handle<T> handle) const noexcept -> bool {
+        return handle.index < std::size(generations_) && generations_[handle.index] == handle.generation;
+    }
+
+    auto generation(uint32_t index) const noexcept -> uint32_t {
+        return index < std::size(generations_) ? generations_[index] : 0;
+    }
+
+    auto reserve(size_t count) -> void {
+        generations_.reserve(count);
+    }
+
+    auto clear() -> void {
+        generations_.clear();
+        freeList_.clear();
+    }
+
+    // number of live slots
+    auto size() const noexcept -> size_t {
+        return std::size(generations_) - std::size(freeList_);
+    }
+
+    // number of slots ever allocated, live or free
+    auto capacity() const noexcept -> size_t {
+        return std::size(generations_);
+    }
+
+private:
+    std::vector<uint32_t> generations_;
+    std::vector<uint32_t> freeList_;
+};
+
+// Stores `value` at `index`, growing `values` when the slot is new.
+template <typename T> inline auto assignSlot(std::vector<T>& values, uint32_t index, const T& value) -> T& {
+    if (index >= std::size(values)) {
+        values.resize(index + 1);
+    }
+
+    values[index] = value;
+
+    return values[index];
+}
+
+struct TextureSlot;
+struct MeshSlot;
+struct MaterialSlot;
+struct ModelSlot;
+struct TextureHandleSlot;
+struct EntitySlot;
+
+using TextureRef = Handle<TextureSlot>;
+using MeshRef = Handle<MeshSlot>;
+using MaterialRef = Handle<MaterialSlot>;
+using ModelRef = Handle<ModelSlot>;
+using TextureHandleRef = Handle<TextureHandleSlot>;
+using EntityRef = Handle<EntitySlot>;
+
+} // namespace Graphics
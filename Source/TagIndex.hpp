@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Graphics {
+
+// Open-addressing hash index from a 64-bit tag to a position in a resource vector.
+// Tags are mostly xxhash64 values, but small constants and bindless handles are used as keys too, so every key is mixed before probing.
+struct TagIndex {
+    static constexpr uint32_t InvalidRef = 0xffffffff;
+
+    auto find(uint64_t tag) const noexcept -> uint32_t {
+        if (keys_.empty()) {
+            return InvalidRef;
+        }
+
+        const size_t mask = std::size(keys_) - 1;
+        for (size_t slot = mix(tag) & mask;; slot = (slot + 1) & mask) {
+            if (refs_[slot] == InvalidRef) {
+                return InvalidRef;
+            }
+
+            if (keys_[slot] == tag) {
+                return refs_[slot];
+            }
+        }
+    }
+
+    // Keeps the first reference registered for a tag, matching the old linear scan semantics.
+    auto insert(uint64_t tag, uint32_t ref) -> bool {
+        if ((count_ + 1) * 2 > std::size(keys_)) {
+            rehash(std::max<size_t>(16, std::size(keys_) * 2));
+        }
+
+        const size_t mask = std::size(keys_) - 1;
+        for (size_t slot = mix(tag) & mask;; slot = (slot + 1) & mask) {
+            if (refs_[slot] == InvalidRef) {
+                keys_[slot] = tag;
+                refs_[slot] = ref;
+                count_++;
+                return true;
+            }
+
+            if (keys_[slot] == tag) {
+                return false;
+            }
+        }
+    }
+
+    auto erase(uint64_t tag) -> bool {
+        if (keys_.empty()) {
+            return false;
+        }
+
+        const size_t mask = std::size(keys_) - 1;
+
+        size_t hole = mix(tag) & mask;
+        for (;; hole = (hole + 1) & mask) {
+            if (refs_[hole] == InvalidRef) {
+                return false;
+            }
+
+            if (keys_[hole] == tag) {
+                break;
+            }
+        }
+
+        // backward-shift deletion keeps probe chains intact without tombstones
+        for (size_t next = (hole + 1) & mask; refs_[next] != InvalidRef; next = (next + 1) & mask) {
+            const size_t home = mix(keys_[next]) & mask;
+            if (((next - home) & mask) >= ((next - hole) & mask)) {
+                keys_[hole] = keys_[next];
+                refs_[hole] = refs_[next];
+                hole = next;
+            }
+        }
+
+        refs_[hole] = InvalidRef;
+        count_--;
+
+        return true;
+    }
+
+    auto reserve(size_t count) -> void {
+        size_t capacity = 16;
+        while (capacity < count * 2) {
+            capacity *= 2;
+        }
+
+        if (capacity > std::size(keys_)) {
+            rehash(capacity);
+        }
+    }
+
+    auto clear() -> void {
+        keys_.clear();
+        refs_.clear();
+        count_ = 0;
+    }
+
+    auto size() const noexcept -> size_t {
+        return count_;
+    }
+
+private:
+    static auto mix(uint64_t key) noexcept -> uint64_t {
+        // splitmix64 finalizer
+        key ^= key >> 30;
+        key *= 0xbf58476d1ce4e5b9ull;
+        key ^= key >> 27;
+        key *= 0x94d049bb133111ebull;
+        key ^= key >> 31;
+        return key;
+    }
+
+    auto rehash(size_t capacity) -> void {
+        auto keys = std::move(keys_);
+        auto refs = std::move(refs_);
+
+        keys_.assign(capacity, 0);
+        refs_.assign(capacity, InvalidRef);
+        count_ = 0;
+
+        for (size_t i = 0; i < std::size(keys); i++) {
+            if (refs[i] != InvalidRef) {
+                insert(keys[i], refs[i]);
+            }
+        }
+    }
+
+    std::vector<uint64_t> keys_;
+    std::vector<uint32_t> refs_;
+    size_t count_ { 0 };
+};
+
+} // namespace Graphics
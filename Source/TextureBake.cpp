@@ -0,0 +1,331 @@
+#include "TextureBake.hpp"
+#include "BlockCompression.hpp"
+#include "ImageDecode.hpp"
+#include "Log.hpp"
+
+#include <tiny_gltf.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <fstream>
+#include <string>
+
+namespace Graphics {
+
+constexpr uint64_t BakedTextureAlignment = 16;
+
+static auto formatChannels(Format format) -> size_t {
+    switch (format) {
+    case Format::R8_UNORM:
+    case Format::R16_FLOAT:
+    case Format::R32_FLOAT:
+        return 1;
+    case Format::R8G8_UNORM:
+    case Format::R16G16_FLOAT:
+    case Format::R32G32_FLOAT:
+        return 2;
+    case Format::R8G8B8_UNORM:
+    case Format::R16G16B16_FLOAT:
+    case Format::R32G32B32_FLOAT:
+        return 3;
+    case Format::R8G8B8A8_UNORM:
+    case Format::R16G16B16A16_FLOAT:
+    case Format::R32G32B32A32_FLOAT:
+        return 4;
+    default:
+        return 0;
+    }
+}
+
+static auto isFloatFormat(Format format) -> bool {
+    return format >= Format::R16_FLOAT && format <= Format::R32G32B32A32_FLOAT;
+}
+
+auto pixelSize(Format format) -> size_t {
+    return formatChannels(format) * (isFloatFormat(format) ? sizeof(float) : sizeof(uint8_t));
+}
+
+auto levelSize(Format format, uint32_t width, uint32_t height) -> size_t {
+    return isBlockCompressed(format) ? compressedSize(format, width, height) : size_t { width } * height * pixelSize(format);
+}
+
+auto textureFormat(TextureUsage usage) -> Format {
+    switch (usage) {
+    case TextureUsage::Color:
+        return Format::BC7_UNORM;
+    case TextureUsage::Normal:
+        return Format::BC5_UNORM;
+    case TextureUsage::Occlusion:
+        return Format::BC4_UNORM;
+    case TextureUsage::Emissive:
+        return Format::BC1_RGB_UNORM;
+    }
+
+    return Format::Undefined;
+}
+
+auto imageUsages(const tinygltf::Model& model) -> std::vector<TextureUsage> {
+    std::vector<std::optional<TextureUsage>> usages(std::size(model.images));
+
+    const auto use = [&](int textureIndex, TextureUsage usage) {
+        if (textureIndex < 0 || static_cast<size_t>(textureIndex) >= std::size(model.textures)) {
+            return;
+        }
+
+        const int source = model.textures[textureIndex].source;
+        if (source < 0 || static_cast<size_t>(source) >= std::size(usages)) {
+            return;
+        }
+
+        // packed occlusion/roughness/metallic images and the like need all their channels
+        auto& current = usages[source];
+        current = !current || *current == usage ? usage : TextureUsage::Color;
+    };
+
+    for (const auto& material : model.materials) {
+        use(material.pbrMetallicRoughness.baseColorTexture.index, TextureUsage::Color);
+        use(material.pbrMetallicRoughness.metallicRoughnessTexture.index, TextureUsage::Color);
+        use(material.normalTexture.index, TextureUsage::Normal);
+        use(material.occlusionTexture.index, TextureUsage::Occlusion);
+        use(material.emissiveTexture.index, TextureUsage::Emissive);
+    }
+
+    std::vector<TextureUsage> result;
+    for (const auto& usage : usages) {
+        result.push_back(usage.value_or(TextureUsage::Color));
+    }
+
+    return result;
+}
+
+auto imageBakePaths(std::string_view modelPath, const tinygltf::Model& model, size_t imageIndex) -> ImageBakePaths {
+    const auto& image = model.images[imageIndex];
+
+    if (image.uri.empty() || image.uri.starts_with("data:")) {
+        const auto source = std::string { modelPath };
+        return { .source = source, .baked = fmt::format("{}.image{}{}", source, imageIndex, BakedTextureExtension) };
+    }
+
+    const auto baseDir = modelPath.substr(0, modelPath.find_last_of("/\\") + 1);
+    const auto source = std::string { baseDir } + image.uri;
+
+    return { .source = source, .baked = source + std::string { BakedTextureExtension } };
+}
+
+template <typename T>
+static auto downsample(const T* source, uint32_t width, uint32_t height, size_t channels, T* destination, uint32_t levelWidth,
+    uint32_t levelHeight) -> void {
+
+    for (uint32_t y = 0; y < levelHeight; y++) {
+        // odd sizes clamp the 2x2 footprint to the last row or column
+        const uint32_t y0 = std::min(y * 2, height - 1);
+        const uint32_t y1 = std::min(y * 2 + 1, height - 1);
+
+        for (uint32_t x = 0; x < levelWidth; x++) {
+            const uint32_t x0 = std::min(x * 2, width - 1);
+            const uint32_t x1 = std::min(x * 2 + 1, width - 1);
+
+            for (size_t c = 0; c < channels; c++) {
+                const float sum = static_cast<float>(source[(y0 * width + x0) * channels + c])
+                    + static_cast<float>(source[(y0 * width + x1) * channels + c])
+                    + static_cast<float>(source[(y1 * width + x0) * channels + c])
+                    + static_cast<float>(source[(y1 * width + x1) * channels + c]);
+
+                if constexpr (std::is_floating_point_v<T>) {
+                    destination[(y * levelWidth + x) * channels + c] = sum * 0.25f;
+                } else {
+                    destination[(y * levelWidth + x) * channels + c] = static_cast<T>(sum * 0.25f + 0.5f);
+                }
+            }
+        }
+    }
+}
+
+auto generateMipChain(const DecodedImage& image) -> std::vector<MipLevel> {
+    const size_t channels = formatChannels(image.format);
+    const size_t texelSize = pixelSize(image.format);
+
+    std::vector<MipLevel> mips;
+    if (channels == 0 || !image) {
+        return mips;
+    }
+
+    const uint8_t* source = std::data(image.data());
+    uint32_t width = image.width;
+    uint32_t height = image.height;
+
+    while (width > 1 || height > 1) {
+        auto& level = mips.emplace_back();
+        level.width = std::max(width / 2, 1u);
+        level.height = std::max(height / 2, 1u);
+        level.pixels.resize(level.width * level.height * texelSize);
+
+        if (isFloatFormat(image.format)) {
+            downsample(reinterpret_cast<const float*>(source), width, height, channels, reinterpret_cast<float*>(std::data(level.pixels)),
+                level.width, level.height);
+        } else {
+            downsample(source, width, height, channels, std::data(level.pixels), level.width, level.height);
+        }
+
+        source = std::data(level.pixels);
+        width = level.width;
+        height = level.height;
+    }
+
+    return mips;
+}
+
+auto writeBakedTexture(std::string_view filepath, Format format, uint32_t width, uint32_t height,
+    std::span<const std::span<const uint8_t>> levelData) -> bool {
+    BakedTextureHeader header;
+    header.format = format;
+    header.width = width;
+    header.height = height;
+    header.levelCount = static_cast<uint32_t>(std::size(levelData));
+
+    std::vector<BakedTextureLevel> levels;
+    uint64_t offset = sizeof(BakedTextureHeader) + std::size(levelData) * sizeof(BakedTextureLevel);
+
+    for (const auto& data : levelData) {
+        auto& level = levels.emplace_back();
+        level.offset = (offset + BakedTextureAlignment - 1) & ~(BakedTextureAlignment - 1);
+        level.size = std::size(data);
+        level.width = width;
+        level.height = height;
+
+        offset = level.offset + level.size;
+        width = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+
+    // written next to the target first, so an interrupted bake never leaves a file that looks valid
+    const auto tempPath = std::string { filepath } + ".tmp";
+
+    {
+        std::ofstream file { tempPath, std::ios::binary | std::ios::trunc };
+        if (!file) {
+            LOG_ERROR("Can't write baked texture {}", tempPath);
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(std::data(levels)), std::size(levels) * sizeof(BakedTextureLevel));
+
+        for (size_t i = 0; i < std::size(levels); i++) {
+            while (static_cast<uint64_t>(file.tellp()) < levels[i].offset) {
+                file.put(0);
+            }
+
+            file.write(reinterpret_cast<const char*>(std::data(levelData[i])), std::size(levelData[i]));
+        }
+
+        if (!file) {
+            LOG_ERROR("Can't write baked texture {}", tempPath);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, filepath, error);
+    if (error) {
+        LOG_ERROR("Can't write baked texture {}: {}", filepath, error.message());
+        return false;
+    }
+
+    return true;
+}
+
+auto bakeTexture(JobSystem& jobs, const DecodedImage& image, Format format, std::string_view bakedPath) -> bool {
+    if (!image) {
+        return false;
+    }
+
+    const auto mips = generateMipChain(image);
+
+    std::vector<std::span<const uint8_t>> levels;
+    levels.push_back(image.data());
+    for (const auto& mip : mips) {
+        levels.push_back(mip.pixels);
+    }
+
+    if (format == Format::Undefined || format == image.format) {
+        return writeBakedTexture(bakedPath, image.format, image.width, image.height, levels);
+    }
+
+    if (!isBlockCompressed(format) || image.format != Format::R8G8B8A8_UNORM) {
+        LOG_ERROR("Can't bake {} images to {}", static_cast<uint32_t>(image.format), static_cast<uint32_t>(format));
+        return false;
+    }
+
+    std::vector<std::vector<uint8_t>> compressed;
+    compressed.push_back(compressImage(jobs, format, image.data(), image.width, image.height));
+    for (const auto& mip : mips) {
+        compressed.push_back(compressImage(jobs, format, mip.pixels, mip.width, mip.height));
+    }
+
+    levels.assign(std::begin(compressed), std::end(compressed));
+
+    return writeBakedTexture(bakedPath, format, image.width, image.height, levels);
+}
+
+auto isBakedTextureFresh(const ImageBakePaths& paths) -> bool {
+    std::error_code error;
+
+    const auto bakedTime = std::filesystem::last_write_time(paths.baked, error);
+    if (error) {
+        return false;
+    }
+
+    const auto sourceTime = std::filesystem::last_write_time(paths.source, error);
+
+    // a baked file without its source is still usable
+    return error || sourceTime <= bakedTime;
+}
+
+auto openBakedTexture(std::string_view filepath) -> BakedTexture {
+    auto file = openMappedFile(filepath);
+    if (!file) {
+        return {};
+    }
+
+    const auto header = reinterpret_cast<const BakedTextureHeader*>(file.data);
+
+    bool valid = file.size >= sizeof(BakedTextureHeader) && header->magic == BakedTextureMagic && header->version == BakedTextureVersion
+        && header->levelCount != 0 && levelSize(header->format, 1, 1) != 0
+        && header->levelCount <= (file.size - sizeof(BakedTextureHeader)) / sizeof(BakedTextureLevel);
+
+    BakedTexture texture { .file = file, .header = header };
+
+    if (valid) {
+        for (const auto& level : bakedTextureLevels(texture)) {
+            valid = valid && level.offset % BakedTextureAlignment == 0 && level.offset <= file.size
+                && level.size <= file.size - level.offset
+                && level.size == levelSize(header->format, level.width, level.height);
+        }
+    }
+
+    if (!valid) {
+        LOG_ERROR("Invalid baked texture {}", filepath);
+        closeBakedTexture(texture);
+        return {};
+    }
+
+    return texture;
+}
+
+auto closeBakedTexture(BakedTexture& texture) -> void {
+    closeMappedFile(texture.file);
+    texture.header = nullptr;
+}
+
+auto bakedTextureLevels(const BakedTexture& texture) -> std::span<const BakedTextureLevel> {
+    return { reinterpret_cast<const BakedTextureLevel*>(texture.header + 1), texture.header->levelCount };
+}
+
+auto bakedTextureLevelData(const BakedTexture& texture, const BakedTextureLevel& level) -> std::span<const uint8_t> {
+    return { reinterpret_cast<const uint8_t*>(texture.file.data + level.offset), static_cast<size_t>(level.size) };
+}
+
+} // namespace Graphics
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "Graphics.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tinygltf {
+class Model;
+}
+
+namespace Graphics {
+
+struct DecodedImage;
+struct JobSystem;
+
+constexpr uint32_t BakedTextureMagic = 0x58544d47; // "GMTX"
+constexpr uint32_t BakedTextureVersion = 1;
+constexpr std::string_view BakedTextureExtension = ".mtex";
+
+// GPU-ready texture with its whole mip chain, either block compressed or in the same pixel layout createTexture2D uploads:
+// header, level table, then the level data at 16 byte aligned offsets, largest level first.
+struct BakedTextureHeader {
+    uint32_t magic { BakedTextureMagic };
+    uint32_t version { BakedTextureVersion };
+    Format format { Format::Undefined };
+    uint32_t width { 0 };
+    uint32_t height { 0 };
+    uint32_t levelCount { 0 };
+    uint64_t reserved { 0 };
+};
+
+struct BakedTextureLevel {
+    uint64_t offset { 0 };
+    uint64_t size { 0 };
+    uint32_t width { 0 };
+    uint32_t height { 0 };
+};
+
+struct MipLevel {
+    uint32_t width { 0 };
+    uint32_t height { 0 };
+    std::vector<uint8_t> pixels;
+};
+
+struct BakedTexture {
+    auto is_valid() const noexcept -> bool {
+        return header != nullptr;
+    }
+
+    operator bool() const {
+        return is_valid();
+    }
+
+    MappedFile file;
+    const BakedTextureHeader* header { nullptr };
+};
+
+// Block compressed format each texture role is baked to.
+enum class TextureUsage {
+    Color,
+    Normal,
+    Occlusion,
+    Emissive,
+};
+
+// Source the image of a glTF model is baked from and where its baked texture lives: next to the image file,
+// or next to the model for embedded images.
+struct ImageBakePaths {
+    std::string source;
+    std::string baked;
+};
+
+// Size of one pixel as uploaded from client memory; float formats are always uploaded from 32-bit floats.
+auto pixelSize(Format format) -> size_t;
+auto levelSize(Format format, uint32_t width, uint32_t height) -> size_t;
+
+auto textureFormat(TextureUsage usage) -> Format;
+// Usage of every image of the model, derived from the material slots it is bound to. Images shared between slots are baked as color.
+auto imageUsages(const tinygltf::Model& model) -> std::vector<TextureUsage>;
+auto imageBakePaths(std::string_view modelPath, const tinygltf::Model& model, size_t imageIndex) -> ImageBakePaths;
+
+// Box filtered levels 1..n of the full mip chain of `image`.
+auto generateMipChain(const DecodedImage& image) -> std::vector<MipLevel>;
+
+// Writes `levels`, largest first, each half the size of the previous one.
+auto writeBakedTexture(std::string_view filepath, Format format, uint32_t width, uint32_t height,
+    std::span<const std::span<const uint8_t>> levels) -> bool;
+
+// Generates the mips of an RGBA8 image and block compresses every level to `format`, or keeps the image format when it is undefined.
+auto bakeTexture(JobSystem& jobs, const DecodedImage& image, Format format, std::string_view bakedPath) -> bool;
+
+// The baked file is ignored once the source is newer.
+auto isBakedTextureFresh(const ImageBakePaths& paths) -> bool;
+
+auto openBakedTexture(std::string_view filepath) -> BakedTexture;
+auto closeBakedTexture(BakedTexture& texture) -> void;
+
+auto bakedTextureLevels(const BakedTexture& texture) -> std::span<const BakedTextureLevel>;
+auto bakedTextureLevelData(const BakedTexture& texture, const BakedTextureLevel& level) -> std::span<const uint8_t>;
+
+} // namespace Graphics
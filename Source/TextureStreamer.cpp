@@ -0,0 +1,209 @@
+#include "TextureStreamer.hpp"
+#include "BlockCompression.hpp"
+
+#include <glad/gl.h>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+
+namespace Graphics {
+
+constexpr uint64_t StagingAlignment = 16;
+
+// Pixel rows, or rows of 4x4 blocks for compressed uploads.
+static auto uploadRows(const TextureUpload& upload) -> uint32_t {
+    return upload.compressedFormat != 0 ? (upload.height + BlockDimension - 1) / BlockDimension : upload.height;
+}
+
+auto createTextureStreamer(const TextureStreamerConfiguration& conf) -> TextureStreamer {
+    const size_t capacity = std::max<size_t>(conf.stagingSize, StagingAlignment);
+
+    constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+    auto id = 0u;
+    glCreateBuffers(1, &id);
+    glNamedBufferStorage(id, capacity, nullptr, flags);
+
+    auto mapped = reinterpret_cast<uint8_t*>(glMapNamedBufferRange(id, 0, capacity, flags));
+
+    TextureStreamer streamer;
+    streamer.buffer = id;
+    streamer.mapped = mapped;
+    streamer.capacity = capacity;
+    streamer.frameBudget = std::max<size_t>(conf.frameBudget, 1);
+
+    return streamer;
+}
+
+auto destroyTextureStreamer(TextureStreamer& streamer, JobSystem& jobs) -> void {
+    // workers may still be writing into the mapping
+    for (const auto& chunk : streamer.chunks) {
+        jobs.wait(*chunk.copied);
+    }
+
+    for (auto& segment : streamer.segments) {
+        const auto sync = reinterpret_cast<GLsync>(segment.fence);
+        glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+        glDeleteSync(sync);
+    }
+
+    if (streamer.buffer != 0) {
+        glUnmapNamedBuffer(streamer.buffer);
+        glDeleteBuffers(1, &streamer.buffer);
+    }
+
+    streamer = {};
+}
+
+auto queueTextureUpload(TextureStreamer& streamer, TextureUpload upload) -> void {
+    streamer.uploads.push_back(std::move(upload));
+}
+
+auto cancelTextureUpload(TextureStreamer& streamer, uint32_t texture) -> void {
+    for (auto& upload : streamer.uploads) {
+        if (upload.texture == texture) {
+            // staged chunks still finish, but nothing is copied into the texture anymore
+            upload.texture = 0;
+            upload.stagedRows = uploadRows(upload);
+        }
+    }
+
+    streamer.uploads.remove_if([](const TextureUpload& upload) { return upload.texture == 0 && upload.pendingChunks == 0; });
+}
+
+static auto retireSegments(TextureStreamer& streamer) -> void {
+    while (!streamer.segments.empty()) {
+        const auto sync = reinterpret_cast<GLsync>(streamer.segments.front().fence);
+
+        const auto result = glClientWaitSync(sync, 0, 0);
+        if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED) {
+            break;
+        }
+
+        glDeleteSync(sync);
+        streamer.readPosition = streamer.segments.front().end;
+        streamer.segments.pop_front();
+    }
+}
+
+static auto copyStagedChunks(TextureStreamer& streamer) -> void {
+    uint64_t issuedEnd = 0;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, streamer.buffer);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // chunks are issued in staging order, so the ring is released in order too
+    while (!streamer.chunks.empty() && streamer.chunks.front().copied->load(std::memory_order_acquire) == 0) {
+        auto& chunk = streamer.chunks.front();
+        auto& upload = *chunk.upload;
+
+        const auto offset = reinterpret_cast<const void*>(static_cast<uintptr_t>(chunk.stagingPosition % streamer.capacity));
+
+        if (upload.texture != 0 && upload.compressedFormat != 0) {
+            const uint32_t y = chunk.firstRow * BlockDimension;
+            const uint32_t height = std::min(chunk.rowCount * BlockDimension, upload.height - y);
+            const auto size = static_cast<GLsizei>(chunk.stagingEnd - chunk.stagingPosition);
+
+            glCompressedTextureSubImage2D(upload.texture, upload.level, 0, y, upload.width, height, upload.compressedFormat, size, offset);
+        } else if (upload.texture != 0) {
+            glTextureSubImage2D(upload.texture, upload.level, 0, chunk.firstRow, upload.width, chunk.rowCount, upload.pixelFormat,
+                upload.pixelType, offset);
+        }
+
+        issuedEnd = chunk.stagingEnd;
+        upload.pendingChunks--;
+
+        if (upload.pendingChunks == 0 && upload.stagedRows == uploadRows(upload)) {
+            if (upload.texture != 0 && upload.generateMipMaps) {
+                glGenerateTextureMipmap(upload.texture);
+            }
+
+            streamer.uploads.remove_if([&upload](const TextureUpload& u) { return &u == &upload; });
+        }
+
+        streamer.chunks.pop_front();
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    if (issuedEnd != 0) {
+        streamer.segments.push_back({ .end = issuedEnd, .fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0) });
+    }
+}
+
+// Reserves `size` bytes of the ring, skipping the tail end when the range would wrap.
+static auto allocateStaging(TextureStreamer& streamer, size_t size) -> std::optional<uint64_t> {
+    uint64_t position = (streamer.writePosition + StagingAlignment - 1) & ~(StagingAlignment - 1);
+
+    if (position % streamer.capacity + size > streamer.capacity) {
+        position += streamer.capacity - position % streamer.capacity;
+    }
+
+    if (position + size - streamer.readPosition > streamer.capacity) {
+        return std::nullopt;
+    }
+
+    streamer.writePosition = position + size;
+
+    return position;
+}
+
+static auto stageUploads(TextureStreamer& streamer, JobSystem& jobs) -> void {
+    streamer.stagedBytes = 0;
+
+    for (auto& upload : streamer.uploads) {
+        const uint32_t rows = uploadRows(upload);
+        const size_t rowSize = std::size(upload.pixels) / rows;
+
+        while (upload.stagedRows < rows) {
+            const size_t budget = streamer.frameBudget > streamer.stagedBytes ? streamer.frameBudget - streamer.stagedBytes : 0;
+
+            // always make progress, even with a budget smaller than a row
+            size_t rowCount = std::min<size_t>(rows - upload.stagedRows, budget / rowSize);
+            rowCount = std::min(rowCount, streamer.capacity / rowSize);
+            if (rowCount == 0) {
+                if (streamer.stagedBytes != 0) {
+                    return;
+                }
+                rowCount = 1;
+            }
+
+            const auto position = allocateStaging(streamer, rowCount * rowSize);
+            if (!position) {
+                return;
+            }
+
+            auto& chunk = streamer.chunks.emplace_back();
+            chunk.upload = &upload;
+            chunk.stagingPosition = *position;
+            chunk.stagingEnd = streamer.writePosition;
+            chunk.firstRow = upload.stagedRows;
+            chunk.rowCount = static_cast<uint32_t>(rowCount);
+            chunk.copied = std::make_unique<JobCounter>(0);
+
+            const auto source = std::data(upload.pixels) + chunk.firstRow * rowSize;
+            const auto destination = streamer.mapped + *position % streamer.capacity;
+            const size_t size = rowCount * rowSize;
+
+            jobs.schedule(*chunk.copied, [source, destination, size] { std::memcpy(destination, source, size); });
+
+            upload.stagedRows += chunk.rowCount;
+            upload.pendingChunks++;
+            streamer.stagedBytes += size;
+        }
+    }
+}
+
+auto updateTextureStreamer(TextureStreamer& streamer, JobSystem& jobs) -> void {
+    if (streamer.buffer == 0) {
+        return;
+    }
+
+    retireSegments(streamer);
+    copyStagedChunks(streamer);
+    stageUploads(streamer, jobs);
+}
+
+} // namespace Graphics
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "Graphics.hpp"
+#include "JobSystem.hpp"
+
+#include <cstdint>
+#include <deque>
+#include <list>
+#include <memory>
+#include <span>
+
+namespace Graphics {
+
+struct BakedTexture;
+struct DecodedImage;
+
+// Texture level copied from CPU pixels to the GPU over several frames; `source` keeps `pixels` alive until the last row is staged.
+struct TextureUpload {
+    uint32_t texture { 0 };
+    uint32_t level { 0 };
+    uint32_t width { 0 };
+    uint32_t height { 0 };
+    uint32_t pixelFormat { 0 };
+    uint32_t pixelType { 0 };
+    // internal format of block compressed pixels, which are staged and copied a row of blocks at a time
+    uint32_t compressedFormat { 0 };
+    bool generateMipMaps { false };
+    std::shared_ptr<const void> source;
+    std::span<const uint8_t> pixels;
+
+    uint32_t stagedRows { 0 };
+    uint32_t pendingChunks { 0 };
+};
+
+// Rows of one upload staged in the ring; a worker copies the pixels in, the context thread issues the texture copy once that finished.
+struct TextureUploadChunk {
+    TextureUpload* upload { nullptr };
+    uint64_t stagingPosition { 0 };
+    uint64_t stagingEnd { 0 };
+    uint32_t firstRow { 0 };
+    uint32_t rowCount { 0 };
+    std::unique_ptr<JobCounter> copied;
+};
+
+// Staging ring range the GPU may still read from until `fence` signals.
+struct StagingSegment {
+    uint64_t end { 0 };
+    void* fence { nullptr };
+};
+
+// Persistently mapped pixel unpack buffer used as a byte ring. Positions grow monotonically, offsets are positions modulo the capacity.
+struct TextureStreamer {
+    uint32_t buffer { 0 };
+    uint8_t* mapped { nullptr };
+    size_t capacity { 0 };
+    size_t frameBudget { 0 };
+
+    uint64_t writePosition { 0 };
+    uint64_t readPosition { 0 };
+    std::deque<StagingSegment> segments;
+
+    std::list<TextureUpload> uploads;
+    std::deque<TextureUploadChunk> chunks;
+
+    // bytes staged during the last update
+    size_t stagedBytes { 0 };
+};
+
+struct TextureStreamerConfiguration {
+    size_t stagingSize { 0 };
+    // bytes staged per frame, a single row is staged even if it exceeds the budget
+    size_t frameBudget { 0 };
+};
+
+auto createTextureStreamer(const TextureStreamerConfiguration& conf) -> TextureStreamer;
+auto destroyTextureStreamer(TextureStreamer& streamer, JobSystem& jobs) -> void;
+
+auto queueTextureUpload(TextureStreamer& streamer, TextureUpload upload) -> void;
+// Drops the pending copies into a texture that is about to be deleted.
+auto cancelTextureUpload(TextureStreamer& streamer, uint32_t texture) -> void;
+
+// Called once per frame on the context thread: retires finished staging ranges, copies staged rows into textures and stages
+// new rows up to the frame budget.
+auto updateTextureStreamer(TextureStreamer& streamer, JobSystem& jobs) -> void;
+
+inline auto pendingTextureUploads(const TextureStreamer& streamer) -> size_t {
+    return std::size(streamer.uploads);
+}
+
+// Creates the texture right away with cleared contents and queues its pixels on the device texture streamer. Images that
+// failed to decode give an invalid texture.
+auto streamTexture2D(Device& device, std::shared_ptr<const DecodedImage> image, TextureConfiguration conf) -> Texture;
+// Same for a baked texture, every level is queued from the mapped file, smallest first.
+auto streamTexture2D(Device& device, std::shared_ptr<const BakedTexture> texture, TextureConfiguration conf) -> Texture;
+
+} // namespace Graphics
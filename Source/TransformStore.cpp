@@ -0,0 +1,208 @@
+#include "TransformStore.hpp"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TRANSFORM_STORE_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define TRANSFORM_STORE_SSE2
+#endif
+
+#include <cassert>
+
+namespace Graphics {
+
+auto TransformStore::resize(size_t count) -> void {
+    for (auto* component : { &positionX, &positionY, &positionZ, &rotationX, &rotationY, &rotationZ }) {
+        component->resize(count, 0.f);
+    }
+
+    for (auto* component : { &rotationW, &scaleX, &scaleY, &scaleZ }) {
+        component->resize(count, 1.f);
+    }
+}
+
+auto TransformStore::set(size_t index, const Transform& transform) -> void {
+    positionX[index] = transform.position.x;
+    positionY[index] = transform.position.y;
+    positionZ[index] = transform.position.z;
+    rotationX[index] = transform.rotation.x;
+    rotationY[index] = transform.rotation.y;
+    rotationZ[index] = transform.rotation.z;
+    rotationW[index] = transform.rotation.w;
+    scaleX[index] = transform.scale.x;
+    scaleY[index] = transform.scale.y;
+    scaleZ[index] = transform.scale.z;
+}
+
+auto TransformStore::get(size_t index) const -> Transform {
+    return { .position = { positionX[index], positionY[index], positionZ[index] },
+        .rotation = quat { rotationW[index], rotationX[index], rotationY[index], rotationZ[index] },
+        .scale = { scaleX[index], scaleY[index], scaleZ[index] } };
+}
+
+// Same arithmetic as the SIMD kernels, the rotation is expected to be normalized.
+auto composeWorldMatrix(const Transform& transform) -> mat4 {
+    const float x = transform.rotation.x, y = transform.rotation.y, z = transform.rotation.z, w = transform.rotation.w;
+    const auto& scale = transform.scale;
+
+    const float xx = x * x, yy = y * y, zz = z * z;
+    const float xy = x * y, xz = x * z, yz = y * z;
+    const float wx = w * x, wy = w * y, wz = w * z;
+
+    return { vec4 { (1.f - 2.f * (yy + zz)) * scale.x, 2.f * (xy + wz) * scale.x, 2.f * (xz - wy) * scale.x, 0.f },
+        vec4 { 2.f * (xy - wz) * scale.y, (1.f - 2.f * (xx + zz)) * scale.y, 2.f * (yz + wx) * scale.y, 0.f },
+        vec4 { 2.f * (xz + wy) * scale.z, 2.f * (yz - wx) * scale.z, (1.f - 2.f * (xx + yy)) * scale.z, 0.f },
+        vec4 { transform.position, 1.f } };
+}
+
+#ifdef TRANSFORM_STORE_SSE2
+struct SSE2 {
+    using Register = __m128;
+    static constexpr size_t Width = 4;
+
+    static auto load(const float* values) -> Register {
+        return _mm_loadu_ps(values);
+    }
+
+    static auto set(float value) -> Register {
+        return _mm_set1_ps(value);
+    }
+
+    static auto add(Register a, Register b) -> Register {
+        return _mm_add_ps(a, b);
+    }
+
+    static auto sub(Register a, Register b) -> Register {
+        return _mm_sub_ps(a, b);
+    }
+
+    static auto mul(Register a, Register b) -> Register {
+        return _mm_mul_ps(a, b);
+    }
+
+    // `rows[c][r]` holds element r of column c of every matrix; a transpose turns that into one column per matrix.
+    static auto store(const Register (&rows)[4][4], mat4* matrices) -> void {
+        for (int c = 0; c < 4; c++) {
+            Register r0 = rows[c][0], r1 = rows[c][1], r2 = rows[c][2], r3 = rows[c][3];
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+            _mm_storeu_ps(&matrices[0][c][0], r0);
+            _mm_storeu_ps(&matrices[1][c][0], r1);
+            _mm_storeu_ps(&matrices[2][c][0], r2);
+            _mm_storeu_ps(&matrices[3][c][0], r3);
+        }
+    }
+};
+#endif
+
+#ifdef TRANSFORM_STORE_AVX2
+struct AVX2 {
+    using Register = __m256;
+    static constexpr size_t Width = 8;
+
+    static auto load(const float* values) -> Register {
+        return _mm256_loadu_ps(values);
+    }
+
+    static auto set(float value) -> Register {
+        return _mm256_set1_ps(value);
+    }
+
+    static auto add(Register a, Register b) -> Register {
+        return _mm256_add_ps(a, b);
+    }
+
+    static auto sub(Register a, Register b) -> Register {
+        return _mm256_sub_ps(a, b);
+    }
+
+    static auto mul(Register a, Register b) -> Register {
+        return _mm256_mul_ps(a, b);
+    }
+
+    // The transpose of SSE2::store within each 128-bit lane, so the low lane holds matrices 0-3 and the high lane 4-7.
+    static auto store(const Register (&rows)[4][4], mat4* matrices) -> void {
+        for (int c = 0; c < 4; c++) {
+            const Register t0 = _mm256_unpacklo_ps(rows[c][0], rows[c][1]);
+            const Register t1 = _mm256_unpackhi_ps(rows[c][0], rows[c][1]);
+            const Register t2 = _mm256_unpacklo_ps(rows[c][2], rows[c][3]);
+            const Register t3 = _mm256_unpackhi_ps(rows[c][2], rows[c][3]);
+
+            const Register columns[4] = { _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0)),
+                _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2)), _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0)),
+                _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2)) };
+
+            for (int i = 0; i < 4; i++) {
+                _mm_storeu_ps(&matrices[i][c][0], _mm256_castps256_ps128(columns[i]));
+                _mm_storeu_ps(&matrices[i + 4][c][0], _mm256_extractf128_ps(columns[i], 1));
+            }
+        }
+    }
+};
+#endif
+
+// World matrices of the `Simd::Width` transforms from `index` on.
+template <typename Simd> static auto composeBatch(const TransformStore& transforms, size_t index, mat4* matrices) -> void {
+    using Register = typename Simd::Register;
+
+    const Register x = Simd::load(std::data(transforms.rotationX) + index);
+    const Register y = Simd::load(std::data(transforms.rotationY) + index);
+    const Register z = Simd::load(std::data(transforms.rotationZ) + index);
+    const Register w = Simd::load(std::data(transforms.rotationW) + index);
+    const Register sx = Simd::load(std::data(transforms.scaleX) + index);
+    const Register sy = Simd::load(std::data(transforms.scaleY) + index);
+    const Register sz = Simd::load(std::data(transforms.scaleZ) + index);
+
+    const Register zero = Simd::set(0.f);
+    const Register one = Simd::set(1.f);
+    const Register two = Simd::set(2.f);
+
+    const Register xx = Simd::mul(x, x), yy = Simd::mul(y, y), zz = Simd::mul(z, z);
+    const Register xy = Simd::mul(x, y), xz = Simd::mul(x, z), yz = Simd::mul(y, z);
+    const Register wx = Simd::mul(w, x), wy = Simd::mul(w, y), wz = Simd::mul(w, z);
+
+    // (1 - 2 (a + b)) s, 2 (a + b) s and 2 (a - b) s, the three shapes of rotation matrix elements
+    const auto diagonal = [&](Register a, Register b, Register scale) {
+        return Simd::mul(Simd::sub(one, Simd::mul(two, Simd::add(a, b))), scale);
+    };
+    const auto sum = [&](Register a, Register b, Register scale) { return Simd::mul(Simd::mul(two, Simd::add(a, b)), scale); };
+    const auto difference = [&](Register a, Register b, Register scale) { return Simd::mul(Simd::mul(two, Simd::sub(a, b)), scale); };
+
+    const Register rows[4][4] = {
+        { diagonal(yy, zz, sx), sum(xy, wz, sx), difference(xz, wy, sx), zero },
+        { difference(xy, wz, sy), diagonal(xx, zz, sy), sum(yz, wx, sy), zero },
+        { sum(xz, wy, sz), difference(yz, wx, sz), diagonal(xx, yy, sz), zero },
+        { Simd::load(std::data(transforms.positionX) + index), Simd::load(std::data(transforms.positionY) + index),
+            Simd::load(std::data(transforms.positionZ) + index), one },
+    };
+
+    Simd::store(rows, matrices);
+}
+
+auto composeWorldMatrices(const TransformStore& transforms, size_t first, std::span<mat4> matrices) -> void {
+    const size_t count = std::size(matrices);
+    assert(first + count <= transforms.size());
+
+    size_t i = 0;
+
+#ifdef TRANSFORM_STORE_AVX2
+    for (; i + AVX2::Width <= count; i += AVX2::Width) {
+        composeBatch<AVX2>(transforms, first + i, std::data(matrices) + i);
+    }
+#endif
+
+#ifdef TRANSFORM_STORE_SSE2
+    for (; i + SSE2::Width <= count; i += SSE2::Width) {
+        composeBatch<SSE2>(transforms, first + i, std::data(matrices) + i);
+    }
+#endif
+
+    for (; i < count; i++) {
+        matrices[i] = composeWorldMatrix(transforms.get(first + i));
+    }
+}
+
+} // namespace Graphics
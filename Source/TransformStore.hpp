@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Math.hpp"
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace Graphics {
+
+struct Transform {
+    vec3 position { 0.f };
+    quat rotation { 1.f, 0.f, 0.f, 0.f };
+    vec3 scale { 1.f };
+};
+
+// Transforms as a structure of arrays, one array per component, so that the same component of consecutive transforms loads
+// into one SIMD register.
+struct TransformStore {
+    auto size() const noexcept -> size_t {
+        return std::size(positionX);
+    }
+
+    // New transforms are identities.
+    auto resize(size_t count) -> void;
+    auto set(size_t index, const Transform& transform) -> void;
+    auto get(size_t index) const -> Transform;
+
+    std::vector<float> positionX;
+    std::vector<float> positionY;
+    std::vector<float> positionZ;
+    std::vector<float> rotationX;
+    std::vector<float> rotationY;
+    std::vector<float> rotationZ;
+    std::vector<float> rotationW;
+    std::vector<float> scaleX;
+    std::vector<float> scaleY;
+    std::vector<float> scaleZ;
+};
+
+// Translation * rotation * scale of one transform, the scalar reference of composeWorldMatrices.
+auto composeWorldMatrix(const Transform& transform) -> mat4;
+
+// Writes the world matrices of transforms [first, first + size(matrices)) into `matrices`, eight at a time with AVX2 or four
+// with SSE2 when the target supports them.
+auto composeWorldMatrices(const TransformStore& transforms, size_t first, std::span<mat4> matrices) -> void;
+
+} // namespace Graphics
@@ -0,0 +1,97 @@
+#include "VertexQuantization.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Graphics {
+
+constexpr float UnormScale = 65535.f;
+
+static auto signNotZero(float value) -> float {
+    return value >= 0.f ? 1.f : -1.f;
+}
+
+auto octahedralEncode(const vec3& direction) -> uint32_t {
+    const float length = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (length == 0.f) {
+        return glm::packSnorm2x16(vec2 { 0.f, 0.f });
+    }
+
+    float x = direction.x / length;
+    float y = direction.y / length;
+
+    // the lower hemisphere folds over the diagonals
+    if (direction.z < 0.f) {
+        const float foldedX = (1.f - std::abs(y)) * signNotZero(x);
+        const float foldedY = (1.f - std::abs(x)) * signNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    return glm::packSnorm2x16(vec2 { x, y });
+}
+
+auto octahedralDecode(uint32_t encoded) -> vec3 {
+    const auto p = glm::unpackSnorm2x16(encoded);
+
+    float x = p.x;
+    float y = p.y;
+    const float z = 1.f - std::abs(x) - std::abs(y);
+
+    if (z < 0.f) {
+        const float unfoldedX = (1.f - std::abs(y)) * signNotZero(x);
+        const float unfoldedY = (1.f - std::abs(x)) * signNotZero(y);
+        x = unfoldedX;
+        y = unfoldedY;
+    }
+
+    const float length = std::sqrt(x * x + y * y + z * z);
+
+    return vec3 { x / length, y / length, z / length };
+}
+
+auto quantizeVertices(std::span<const Vertex> vertices, std::span<PackedPosition> positions, std::span<PackedAttributes> attributes)
+    -> PositionQuantization {
+    vec3 minPosition { std::numeric_limits<float>::max() };
+    vec3 maxPosition { std::numeric_limits<float>::lowest() };
+
+    for (const auto& vertex : vertices) {
+        for (int c = 0; c < 3; c++) {
+            minPosition[c] = std::min(minPosition[c], vertex.position[c]);
+            maxPosition[c] = std::max(maxPosition[c], vertex.position[c]);
+        }
+    }
+
+    PositionQuantization quantization;
+    if (vertices.empty()) {
+        return quantization;
+    }
+
+    quantization.offset = minPosition;
+    quantization.scale = maxPosition - minPosition;
+
+    for (size_t i = 0; i < std::size(vertices); i++) {
+        const auto& vertex = vertices[i];
+        auto& position = positions[i];
+
+        for (int c = 0; c < 3; c++) {
+            // flat axes keep a zero scale and quantize to zero
+            const float extent = quantization.scale[c];
+            const float normalized = extent > 0.f ? (vertex.position[c] - quantization.offset[c]) / extent : 0.f;
+            position.position[c] = static_cast<uint16_t>(std::lround(std::clamp(normalized, 0.f, 1.f) * UnormScale));
+        }
+
+        position.position[3] = 0;
+
+        attributes[i] = {
+            .normal = octahedralEncode(vertex.normal),
+            .tangent = octahedralEncode(vertex.tangent),
+            .uv = glm::packHalf2x16(vertex.uv),
+        };
+    }
+
+    return quantization;
+}
+
+} // namespace Graphics
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "Graphics.hpp"
+
+#include <span>
+
+namespace Graphics {
+
+struct PositionQuantization {
+    vec3 offset { 0.f };
+    vec3 scale { 1.f };
+};
+
+auto octahedralEncode(const vec3& direction) -> uint32_t;
+auto octahedralDecode(uint32_t encoded) -> vec3;
+
+// Packs `vertices` into the two streams, which must be as large, with positions quantized to the bounds of all of them.
+auto quantizeVertices(std::span<const Vertex> vertices, std::span<PackedPosition> positions, std::span<PackedAttributes> attributes)
+    -> PositionQuantization;
+
+} // namespace Graphics
@@ -0,0 +1,129 @@
+#include "ImageDecode.hpp"
+#include "JobSystem.hpp"
+#include "Log.hpp"
+#include "TextureBake.hpp"
+
+#include <fmt/core.h>
+#include <nlohmann/json.hpp>
+
+#define TINYGLTF_IMPLEMENTATION
+#define TINYGLTF_NO_INCLUDE_JSON
+#define TINYGLTF_NO_STB_IMAGE
+#define TINYGLTF_NO_STB_IMAGE_WRITE
+
+#include <tiny_gltf.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <span>
+#include <string>
+#include <vector>
+
+// Bakes the images of every glTF model found under the given folders (Assets by default) into block compressed textures with all
+// mips, where the sample looks for them. Textures that are newer than their source are skipped unless --force is given.
+
+static auto storeEncodedImage(tinygltf::Image*, const int imageIndex, std::string*, std::string*, int, int, const unsigned char* bytes,
+    int size, void* userData) -> bool {
+
+    auto& encodedImages = *static_cast<std::vector<std::vector<uint8_t>>*>(userData);
+    if (static_cast<size_t>(imageIndex) >= std::size(encodedImages)) {
+        encodedImages.resize(imageIndex + 1);
+    }
+
+    encodedImages[imageIndex].assign(bytes, bytes + size);
+
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    bool force = false;
+    std::vector<std::filesystem::path> folders;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string_view arg { argv[i] };
+        if (arg == "--force") {
+            force = true;
+        } else {
+            folders.emplace_back(arg);
+        }
+    }
+
+    if (folders.empty()) {
+        folders.emplace_back(RESOURCE_PATH);
+    }
+
+    std::vector<std::string> modelPaths;
+    for (const auto& folder : folders) {
+        std::error_code error;
+        for (const auto& entry : std::filesystem::recursive_directory_iterator(folder, error)) {
+            const auto ext = entry.path().extension();
+            if (entry.is_regular_file() && (ext == ".gltf" || ext == ".glb")) {
+                modelPaths.push_back(entry.path().string());
+            }
+        }
+
+        if (error) {
+            LOG_ERROR("Can't read {}: {}", folder.string(), error.message());
+            return EXIT_FAILURE;
+        }
+    }
+
+    using clock = std::chrono::steady_clock;
+
+    const auto start = clock::now();
+
+    Graphics::JobSystem jobs;
+    size_t imageCount = 0;
+    std::atomic<size_t> baked { 0 };
+    std::atomic<size_t> failed { 0 };
+
+    for (const auto& modelPath : modelPaths) {
+        tinygltf::Model model;
+        tinygltf::TinyGLTF loader;
+        std::string err;
+        std::string warn;
+
+        std::vector<std::vector<uint8_t>> encodedImages;
+        loader.SetImageLoader(storeEncodedImage, &encodedImages);
+
+        const bool binary = std::filesystem::path { modelPath }.extension() == ".glb";
+        const bool loaded = binary ? loader.LoadBinaryFromFile(&model, &err, &warn, modelPath)
+                                   : loader.LoadASCIIFromFile(&model, &err, &warn, modelPath);
+
+        if (!loaded) {
+            LOG_ERROR("{}: {} {}", modelPath, err, warn);
+            failed++;
+            continue;
+        }
+
+        const auto usages = Graphics::imageUsages(model);
+        imageCount += std::size(model.images);
+
+        jobs.parallelFor(std::size(model.images), [&](size_t i) {
+            const auto paths = Graphics::imageBakePaths(modelPath, model, i);
+            if (!force && Graphics::isBakedTextureFresh(paths)) {
+                return;
+            }
+
+            const auto encoded = i < std::size(encodedImages) ? std::span<const uint8_t> { encodedImages[i] } : std::span<const uint8_t> {};
+            const auto image = Graphics::decodeImage(encoded, 4);
+
+            if (Graphics::bakeTexture(jobs, image, Graphics::textureFormat(usages[i]), paths.baked)) {
+                fmt::println("Baked {}", paths.baked);
+                baked++;
+            } else {
+                LOG_ERROR("Failed to bake image {} of {}", i, modelPath);
+                failed++;
+            }
+        });
+    }
+
+    const auto elapsed = std::chrono::duration<double>(clock::now() - start).count();
+
+    fmt::println("{} models, {} images, {} baked, {} failed in {:.2f} s on {} threads", std::size(modelPaths), imageCount,
+        baked.load(), failed.load(), elapsed, jobs.threadCount());
+
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}